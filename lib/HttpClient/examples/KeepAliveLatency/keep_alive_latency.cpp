@@ -0,0 +1,105 @@
+/*
+ * Keep-Alive Latency Measurement for PioSystem
+ *
+ * Measures what the HttpClientManager connection pool saves per request.
+ * The same GET is timed REQUESTS_PER_RUN times with HttpConfig::keepAlive
+ * off (a new TCP connection per request), then with it on (one pooled
+ * connection). The sketch prints min / median / p95 latency for both runs,
+ * plus the pool counters that confirm the sockets were really reused.
+ *
+ * Point TARGET_URL at a server on the same LAN that answers a small body
+ * over HTTP/1.1 with keep-alive, e.g. another PioSystem board at
+ * http://<ip>/api/wifi/status. Use an https:// URL to include the TLS
+ * handshake in the comparison.
+ *
+ * Hardware: ESP32-S3 with WiFi capability
+ *
+ * Author: PioSystem
+ * Date: 2025
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <vector>
+#include "../../SerialDebug/src/SerialDebug.h"
+#include "../src/httpclient.h"
+
+// Configuration - UPDATE THESE VALUES
+const char* WIFI_SSID = "YourWiFiSSID";
+const char* WIFI_PASSWORD = "YourWiFiPassword";
+const String TARGET_URL = "http://192.168.1.50/api/wifi/status";
+
+const int REQUESTS_PER_RUN = 200;
+const int WARMUP_REQUESTS = 5;
+
+HttpClientManager httpClient;
+
+// Times REQUESTS_PER_RUN GETs and prints their latency distribution
+void measureRun(const char* label, bool keepAlive) {
+    HttpConfig config;
+    config.keepAlive = keepAlive;
+    config.verifySsl = false;
+    httpClient.begin(config);
+    httpClient.closeIdleConnections();
+
+    for (int i = 0; i < WARMUP_REQUESTS; i++) {
+        httpClient.get(TARGET_URL);
+    }
+    httpClient.resetStats();
+
+    std::vector<uint32_t> samples;
+    samples.reserve(REQUESTS_PER_RUN);
+    int failures = 0;
+
+    for (int i = 0; i < REQUESTS_PER_RUN; i++) {
+        uint32_t started = micros();
+        HttpResponse response = httpClient.get(TARGET_URL);
+        uint32_t elapsed = micros() - started;
+
+        if (response.success) {
+            samples.push_back(elapsed);
+        } else {
+            failures++;
+        }
+    }
+
+    std::map<String, int> stats = httpClient.getStats();
+    if (samples.empty()) {
+        Serial.printf("%-10s all %d requests failed: %s\n", label, failures, httpClient.getLastError().c_str());
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Serial.printf("%-10s min %6lu us  median %6lu us  p95 %6lu us  (%u ok, %d failed, %d opened, %d reused)\n",
+                  label,
+                  (unsigned long)samples.front(),
+                  (unsigned long)samples[samples.size() / 2],
+                  (unsigned long)samples[(samples.size() * 95) / 100],
+                  (unsigned)samples.size(), failures,
+                  stats["connections_opened"], stats["connections_reused"]);
+}
+
+void setup() {
+    Serial.begin(115200);
+    delay(2000);
+
+    DEBUG_PRINTLN("=== HttpClient keep-alive latency ===");
+
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(250);
+    }
+    // Keep the radio awake so power save does not dominate the numbers
+    WiFi.setSleep(false);
+    DEBUG_PRINTLN("WiFi connected! IP: " + WiFi.localIP().toString());
+    DEBUG_PRINTLN("Target: " + TARGET_URL);
+
+    measureRun("fresh", false);
+    measureRun("keep-alive", true);
+}
+
+void loop() {
+    delay(1000);
+}
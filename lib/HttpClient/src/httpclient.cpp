@@ -4,15 +4,17 @@
 #include <base64.h>
 #include <SPIFFS.h>
 
-SemaphoreHandle_t httpClientMutex = NULL;
+// Only evaluated when debug output is enabled; formatting happens on the log task
+#define HTTP_DEBUG(format, ...) do { if (_debugEnabled) { LOG_INFO("[HttpClient] " format, ##__VA_ARGS__); } } while (0)
 
 HttpClientManager::HttpClientManager() : 
+    _poolMutex(xSemaphoreCreateMutex()),
+    _stateMutex(xSemaphoreCreateMutex()),
+    _inFlight(0),
+    _idleCpu(CPU_LOW),
+    _config(std::make_shared<const HttpConfig>()),
     _debugEnabled(false) {
 
-    if (httpClientMutex == NULL) {
-        httpClientMutex = xSemaphoreCreateMutex();
-    }
-    
     // Initialize statistics map with explicit values
     _stats.clear();
     _stats.insert(std::make_pair("requests_total", 0));
@@ -20,17 +22,31 @@ HttpClientManager::HttpClientManager() :
     _stats.insert(std::make_pair("requests_failed", 0));
     _stats.insert(std::make_pair("bytes_sent", 0));
     _stats.insert(std::make_pair("bytes_received", 0));
+    _stats.insert(std::make_pair("connections_opened", 0));
+    _stats.insert(std::make_pair("connections_reused", 0));
+    _stats.insert(std::make_pair("connections_evicted", 0));
+    _stats.insert(std::make_pair("connections_stale", 0));
 }
 
 HttpClientManager::~HttpClientManager() {
-    _httpClient.end();
+    for (PooledConnection& connection : _pool) {
+        closeConnection(connection);
+    }
+    if (_poolMutex != NULL) {
+        vSemaphoreDelete(_poolMutex);
+    }
+    if (_stateMutex != NULL) {
+        vSemaphoreDelete(_stateMutex);
+    }
 }
 
 bool HttpClientManager::begin(const HttpConfig& config) {
-    _config = config;
-    // _httpClient.setReuse(true);
+    updateConfig([&config](HttpConfig& current) { current = config; });
+    if (!config.keepAlive) {
+        closeIdleConnections();
+    }
     
-    debug("HTTP Client initialized");
+    HTTP_DEBUG("HTTP Client initialized");
     return true;
 }
 
@@ -52,25 +68,56 @@ void HttpClientManager::setBasicAuth(const String& username, const String& passw
     if (valb > -6) encoded += chars[((val << 8) >> (valb + 8)) & 0x3F];
     while (encoded.length() % 4) encoded += '=';
     
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
     _basicAuthHeader = "Basic " + encoded;
-    debug("Basic authentication set for user: " + username);
+    xSemaphoreGive(_stateMutex);
+    HTTP_DEBUG("Basic authentication set for user: %s", username.c_str());
 }
 
 void HttpClientManager::setBearerToken(const String& token) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
     _bearerToken = "Bearer " + token;
-    debug("Bearer token set");
+    xSemaphoreGive(_stateMutex);
+    HTTP_DEBUG("Bearer token set");
+}
+
+void HttpClientManager::setCACertificate(const char* caCert) {
+    std::shared_ptr<const String> certificate;
+    if (caCert != nullptr && caCert[0] != '\0') {
+        certificate = std::make_shared<const String>(caCert);
+    }
+    
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _caCert = certificate;
+    xSemaphoreGive(_stateMutex);
+    HTTP_DEBUG("CA certificate %s", certificate ? "set" : "cleared");
 }
 
 void HttpClientManager::setDefaultHeaders(const std::map<String, String>& headers) {
-    _config.defaultHeaders = headers;
+    updateConfig([&headers](HttpConfig& config) { config.defaultHeaders = headers; });
 }
 
 void HttpClientManager::addDefaultHeader(const String& name, const String& value) {
-    _config.defaultHeaders[name] = value;
+    updateConfig([&name, &value](HttpConfig& config) { config.defaultHeaders[name] = value; });
 }
 
 void HttpClientManager::removeDefaultHeader(const String& name) {
-    _config.defaultHeaders.erase(name);
+    updateConfig([&name](HttpConfig& config) { config.defaultHeaders.erase(name); });
+}
+
+std::shared_ptr<const HttpConfig> HttpClientManager::currentConfig() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    std::shared_ptr<const HttpConfig> config = _config;
+    xSemaphoreGive(_stateMutex);
+    return config;
+}
+
+void HttpClientManager::updateConfig(std::function<void(HttpConfig&)> change) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    std::shared_ptr<HttpConfig> config = std::make_shared<HttpConfig>(*_config);
+    change(*config);
+    _config = config;
+    xSemaphoreGive(_stateMutex);
 }
 
 HttpResponse HttpClientManager::get(const String& url, const std::map<String, String>& headers) {
@@ -97,64 +144,63 @@ HttpResponse HttpClientManager::patch(const String& url, const String& body,
 }
 
 HttpResponse HttpClientManager::request(WebRequestMethod method, const String& url, const String& body,
-                                      const String& contentType, const std::map<String, String>& headers) {
+                                      const String& contentType, const std::map<String, String>& headers,
+                                      unsigned long timeout) {
     HttpResponse response;
-    if (xSemaphoreTake(httpClientMutex, portMAX_DELAY) == pdFALSE) {
-        _lastError = "Failed to acquire httpClientMutex";
-        response.error = _lastError;
-        updateStats("requests_failed");
-        return response;
-    }
-
     unsigned long startTime = millis();
     
     updateStats("requests_total");
     
-    debug("Making " + methodToString(method) + " request to: " + url);
+    HTTP_DEBUG("Making %s request to: %s", methodToString(method).c_str(), url.c_str());
     
-    cpu_freq lastCpu = __lastCPUSet;
-    setCPU(CPU_HIGH);
-    if (!setupRequest(url, headers)) {
-        response.error = _lastError;
+    String error;
+    PooledConnection* connection = setupRequest(url, headers, timeout > 0 ? timeout : currentConfig()->timeout, error);
+    if (connection == nullptr) {
+        response.error = error;
+        response.responseTime = millis() - startTime;
+        setLastError(error);
         updateStats("requests_failed");
+        HTTP_DEBUG("%s", error.c_str());
         return response;
     }
+    HTTPClient& http = connection->http;
+    beginActivity();
     
     // Set content type if provided
     if (!contentType.isEmpty() && !body.isEmpty()) {
-        _httpClient.addHeader("Content-Type", contentType);
+        http.addHeader("Content-Type", contentType);
     }
     
     // Apply request-specific headers
-    applyHeaders(headers);
+    applyHeaders(http, headers);
     
     // Make the request
     int httpCode = -1;
     switch (method) {
         case HTTP_GET:
-            httpCode = _httpClient.GET();
+            httpCode = http.GET();
             break;
         case HTTP_POST:
-            httpCode = _httpClient.POST(body);
+            httpCode = http.POST(body);
             updateStats("bytes_sent", body.length());
             break;
         case HTTP_PUT:
-            httpCode = _httpClient.PUT(body);
+            httpCode = http.PUT(body);
             updateStats("bytes_sent", body.length());
             break;
         case HTTP_DELETE:
-            httpCode = _httpClient.sendRequest("DELETE", body);
+            httpCode = http.sendRequest("DELETE", body);
             if (!body.isEmpty()) updateStats("bytes_sent", body.length());
             break;
         case HTTP_PATCH:
-            httpCode = _httpClient.PATCH(body);
+            httpCode = http.PATCH(body);
             updateStats("bytes_sent", body.length());
             break;
         case HTTP_HEAD:
-            httpCode = _httpClient.sendRequest("HEAD");
+            httpCode = http.sendRequest("HEAD");
             break;
         case HTTP_OPTIONS:
-            httpCode = _httpClient.sendRequest("OPTIONS");
+            httpCode = http.sendRequest("OPTIONS");
             break;
         default:
             httpCode = -1;
@@ -166,30 +212,29 @@ HttpResponse HttpClientManager::request(WebRequestMethod method, const String& u
     
     if (httpCode > 0) {
         response.success = (httpCode >= 200 && httpCode < 300);
-        response.body = _httpClient.getString();
-        response.headers = getResponseHeaders();
+        response.body = http.getString();
+        response.headers = getResponseHeaders(http);
         
         updateStats("bytes_received", response.body.length());
         
         if (response.success) {
             updateStats("requests_success");
-            debug("Request successful - Status: " + String(httpCode) + ", Time: " + String(response.responseTime) + "ms");
+            HTTP_DEBUG("Request successful - Status: %d, Time: %lums", httpCode, response.responseTime);
         } else {
             updateStats("requests_failed");
-            debug("Request failed - Status: " + String(httpCode) + ", Time: " + String(response.responseTime) + "ms");
+            HTTP_DEBUG("Request failed - Status: %d, Time: %lums", httpCode, response.responseTime);
         }
     } else {
         response.success = false;
         response.error = "HTTP request failed with code: " + String(httpCode);
-        _lastError = response.error;
+        setLastError(response.error);
         updateStats("requests_failed");
-        debug(response.error);
+        HTTP_DEBUG("%s", response.error.c_str());
     }
     
-    _httpClient.end();
-    setCPU(lastCpu);
-    xSemaphoreGive(httpClientMutex);
-    delay(5);
+    // Transport errors leave the socket in an unknown state
+    releaseConnection(connection, httpCode > 0);
+    endActivity();
     return response;
 }
 
@@ -200,7 +245,7 @@ JsonDocument HttpClientManager::getJson(const String& url, const std::map<String
     if (response.success && !response.body.isEmpty()) {
         DeserializationError error = deserializeJson(doc, response.body);
         if (error) {
-            debug("JSON parsing failed: " + String(error.c_str()));
+            HTTP_DEBUG("JSON parsing failed: %s", error.c_str());
             doc.clear();
             doc["error"] = "JSON parsing failed";
             doc["raw_response"] = response.body;
@@ -224,7 +269,7 @@ JsonDocument HttpClientManager::postJson(const String& url, const JsonDocument&
     if (response.success && !response.body.isEmpty()) {
         DeserializationError error = deserializeJson(doc, response.body);
         if (error) {
-            debug("JSON parsing failed: " + String(error.c_str()));
+            HTTP_DEBUG("JSON parsing failed: %s", error.c_str());
             doc.clear();
             doc["error"] = "JSON parsing failed";
             doc["raw_response"] = response.body;
@@ -248,7 +293,7 @@ JsonDocument HttpClientManager::putJson(const String& url, const JsonDocument& j
     if (response.success && !response.body.isEmpty()) {
         DeserializationError error = deserializeJson(doc, response.body);
         if (error) {
-            debug("JSON parsing failed: " + String(error.c_str()));
+            HTTP_DEBUG("JSON parsing failed: %s", error.c_str());
             doc.clear();
             doc["error"] = "JSON parsing failed";
             doc["raw_response"] = response.body;
@@ -263,34 +308,40 @@ JsonDocument HttpClientManager::putJson(const String& url, const JsonDocument& j
 
 bool HttpClientManager::downloadFile(const String& url, const String& filePath,
                                     std::function<void(size_t current, size_t total)> onProgress) {
-    debug("Downloading file from: " + url + " to: " + filePath);
+    HTTP_DEBUG("Downloading file from: %s to: %s", url.c_str(), filePath.c_str());
     
-    if (!setupRequest(url, {})) {
+    String error;
+    PooledConnection* connection = setupRequest(url, {}, currentConfig()->timeout, error);
+    if (connection == nullptr) {
+        setLastError(error);
         return false;
     }
+    HTTPClient& http = connection->http;
     
-    int httpCode = _httpClient.GET();
+    int httpCode = http.GET();
     if (httpCode != 200) {
-        _lastError = "Download failed with HTTP code: " + String(httpCode);
-        debug(_lastError);
-        _httpClient.end();
+        error = "Download failed with HTTP code: " + String(httpCode);
+        setLastError(error);
+        HTTP_DEBUG("%s", error.c_str());
+        releaseConnection(connection, false);
         return false;
     }
     
-    WiFiClient* stream = _httpClient.getStreamPtr();
-    size_t totalSize = _httpClient.getSize();
+    WiFiClient* stream = http.getStreamPtr();
+    size_t totalSize = http.getSize();
     size_t downloadedSize = 0;
     
     File file = SPIFFS.open(filePath, FILE_WRITE);
     if (!file) {
-        _lastError = "Failed to open file for writing: " + filePath;
-        debug(_lastError);
-        _httpClient.end();
+        error = "Failed to open file for writing: " + filePath;
+        setLastError(error);
+        HTTP_DEBUG("%s", error.c_str());
+        releaseConnection(connection, false);
         return false;
     }
     
     uint8_t buff[1024];
-    while (_httpClient.connected() && (downloadedSize < totalSize || totalSize == 0)) {
+    while (http.connected() && (downloadedSize < totalSize || totalSize == 0)) {
         size_t available = stream->available();
         if (available) {
             size_t readBytes = stream->readBytes(buff, _min(available, sizeof(buff)));
@@ -305,10 +356,11 @@ bool HttpClientManager::downloadFile(const String& url, const String& filePath,
     }
     
     file.close();
-    _httpClient.end();
+    // Only a body read to its announced end leaves the socket reusable
+    releaseConnection(connection, totalSize > 0 && downloadedSize == totalSize);
     
     updateStats("bytes_received", downloadedSize);
-    debug("Download completed - Size: " + String(downloadedSize) + " bytes");
+    HTTP_DEBUG("Download completed - Size: %u bytes", (unsigned)downloadedSize);
     return true;
 }
 
@@ -316,30 +368,32 @@ HttpResponse HttpClientManager::uploadFile(const String& url, const String& file
                                          const String& fieldName, const std::map<String, String>& headers) {
     HttpResponse response;
     
-    debug("Uploading file: " + filePath + " to: " + url);
+    HTTP_DEBUG("Uploading file: %s to: %s", filePath.c_str(), url.c_str());
     
     File file = SPIFFS.open(filePath, FILE_READ);
     if (!file) {
         response.error = "Failed to open file: " + filePath;
-        debug(response.error);
+        HTTP_DEBUG("%s", response.error.c_str());
         return response;
     }
     
     size_t fileSize = file.size();
     file.close();
     
-    if (!setupRequest(url, headers)) {
-        response.error = _lastError;
+    PooledConnection* connection = setupRequest(url, headers, currentConfig()->timeout, response.error);
+    if (connection == nullptr) {
+        setLastError(response.error);
         return response;
     }
+    HTTPClient& http = connection->http;
     
     // Note: This is a simplified upload. For proper multipart form data,
     // you might need a more sophisticated implementation or additional library
     String boundary = "----ESP32FormBoundary" + String(random(0xFFFF), HEX);
     String contentType = "multipart/form-data; boundary=" + boundary;
     
-    _httpClient.addHeader("Content-Type", contentType);
-    applyHeaders(headers);
+    http.addHeader("Content-Type", contentType);
+    applyHeaders(http, headers);
     
     // This is a basic implementation - for production use, consider using a dedicated multipart library
     String body = "--" + boundary + "\r\n";
@@ -348,96 +402,321 @@ HttpResponse HttpClientManager::uploadFile(const String& url, const String& file
     // File content would be added here
     body += "\r\n--" + boundary + "--\r\n";
     
-    int httpCode = _httpClient.POST(body);
+    int httpCode = http.POST(body);
     response.statusCode = httpCode;
     response.success = (httpCode >= 200 && httpCode < 300);
-    response.body = _httpClient.getString();
+    response.body = http.getString();
     
     if (!response.success) {
         response.error = "Upload failed with HTTP code: " + String(httpCode);
-        debug(response.error);
+        HTTP_DEBUG("%s", response.error.c_str());
     }
     
-    _httpClient.end();
+    releaseConnection(connection, httpCode > 0);
     updateStats("bytes_sent", fileSize);
     return response;
 }
 
 String HttpClientManager::getLastError() {
-    return _lastError;
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    String error = _lastError;
+    xSemaphoreGive(_stateMutex);
+    return error;
 }
 
 std::map<String, int> HttpClientManager::getStats() {
-    return _stats;
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    std::map<String, int> stats = _stats;
+    xSemaphoreGive(_stateMutex);
+    return stats;
 }
 
 void HttpClientManager::resetStats() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
     for (auto& stat : _stats) {
         stat.second = 0;
     }
+    xSemaphoreGive(_stateMutex);
 }
 
 void HttpClientManager::setDebugEnabled(bool enabled) {
     _debugEnabled = enabled;
 }
 
-bool HttpClientManager::setupRequest(const String& url, const std::map<String, String>& headers) {
-    _lastError = "";
-    
+void HttpClientManager::closeIdleConnections() {
+    xSemaphoreTake(_poolMutex, portMAX_DELAY);
+    for (PooledConnection& connection : _pool) {
+        if (!connection.inUse) {
+            closeConnection(connection);
+        }
+    }
+    xSemaphoreGive(_poolMutex);
+}
+
+PooledConnection* HttpClientManager::setupRequest(const String& url, const std::map<String, String>& headers,
+                                                  unsigned long timeout, String& error) {
     if (url.isEmpty()) {
-        _lastError = "URL cannot be empty";
-        return false;
+        error = "URL cannot be empty";
+        return nullptr;
+    }
+
+    // One consistent view of the settings for the whole request
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    std::shared_ptr<const HttpConfig> config = _config;
+    std::shared_ptr<const String> caCert = _caCert;
+    String basicAuthHeader = _basicAuthHeader;
+    String bearerToken = _bearerToken;
+    xSemaphoreGive(_stateMutex);
+    
+    PooledConnection* connection = acquireConnection(url, timeout, *config, error);
+    if (connection == nullptr) {
+        return nullptr;
+    }
+    HTTPClient& http = connection->http;
+
+    // The slot's transport must match the scheme and the CA it verifies
+    // against; a plain socket cannot carry TLS
+    bool secure = url.startsWith("https://");
+    if (!secure || !config->verifySsl) {
+        caCert.reset();
+    }
+    if (!connection->client || connection->secure != secure || connection->caCert != caCert) {
+        if (secure) {
+            WiFiClientSecure* tls = new WiFiClientSecure();
+            if (caCert) {
+                tls->setCACert(caCert->c_str());
+            } else {
+                // Without a CA, as HTTPClient's own TLS transport does
+                tls->setInsecure();
+            }
+            connection->client.reset(tls);
+        } else {
+            connection->client.reset(new WiFiClient());
+        }
+        connection->secure = secure;
+        connection->caCert = caCert;
     }
 
-    _httpClient.begin(url);
+    // With reuse on, begin() keeps a socket that is still connected to this host
+    http.setReuse(config->keepAlive);
+    if (!http.begin(*connection->client, url)) {
+        error = "Invalid URL: " + url;
+        releaseConnection(connection, false);
+        return nullptr;
+    }
     
-    // Configure timeouts
-    _httpClient.setTimeout(_config.timeout);
-    _httpClient.setConnectTimeout(_config.connectTimeout);
+    // Configure timeouts; the per-request timeout also caps the connect phase
+    http.setTimeout(std::min(timeout, 65535UL));
+    http.setConnectTimeout(std::min(timeout, config->connectTimeout));
     
     // Configure redirects
-    _httpClient.setFollowRedirects(_config.followRedirects ? HTTPC_STRICT_FOLLOW_REDIRECTS : HTTPC_DISABLE_FOLLOW_REDIRECTS);
+    http.setFollowRedirects(config->followRedirects ? HTTPC_STRICT_FOLLOW_REDIRECTS : HTTPC_DISABLE_FOLLOW_REDIRECTS);
     
     // Set user agent
-    _httpClient.setUserAgent(_config.userAgent);
+    http.setUserAgent(config->userAgent);
     
     // Apply default headers
-    applyHeaders(_config.defaultHeaders);
+    applyHeaders(http, config->defaultHeaders);
     
     // Apply authentication
-    if (!_basicAuthHeader.isEmpty()) {
-        _httpClient.addHeader("Authorization", _basicAuthHeader);
-    } else if (!_bearerToken.isEmpty()) {
-        _httpClient.addHeader("Authorization", _bearerToken);
+    if (!basicAuthHeader.isEmpty()) {
+        http.addHeader("Authorization", basicAuthHeader);
+    } else if (!bearerToken.isEmpty()) {
+        http.addHeader("Authorization", bearerToken);
     }
     
-    return true;
+    return connection;
+}
+
+PooledConnection* HttpClientManager::acquireConnection(const String& url, unsigned long timeout,
+                                                       const HttpConfig& config, String& error) {
+    String host = hostKey(url);
+    if (host.isEmpty()) {
+        error = "Invalid URL: " + url;
+        return nullptr;
+    }
+
+    // Woken by releaseConnection(); registered under the same lock as the
+    // failed attempt, so a release in between is never missed
+    StaticSemaphore_t wakeStorage;
+    SemaphoreHandle_t wake = xSemaphoreCreateBinaryStatic(&wakeStorage);
+    PooledConnection* connection = nullptr;
+    unsigned long startTime = millis();
+
+    xSemaphoreTake(_poolMutex, portMAX_DELAY);
+    for (;;) {
+        connection = takeConnection(host, config);
+        unsigned long waited = millis() - startTime;
+        if (connection != nullptr || waited >= timeout) {
+            break;
+        }
+        _waiters.push_back(wake);
+        xSemaphoreGive(_poolMutex);
+
+        xSemaphoreTake(wake, pdMS_TO_TICKS(timeout - waited));
+
+        xSemaphoreTake(_poolMutex, portMAX_DELAY);
+        _waiters.erase(std::remove(_waiters.begin(), _waiters.end(), wake), _waiters.end());
+    }
+    xSemaphoreGive(_poolMutex);
+    vSemaphoreDelete(wake);
+
+    if (connection == nullptr) {
+        error = "No free connection for " + host;
+    }
+    return connection;
 }
 
-void HttpClientManager::applyHeaders(const std::map<String, String>& headers) {
+PooledConnection* HttpClientManager::takeConnection(const String& host, const HttpConfig& config) {
+    unsigned long now = millis();
+    PooledConnection* reusable = nullptr;
+    PooledConnection* empty = nullptr;
+    PooledConnection* oldest = nullptr;
+    int hostConnections = 0;
+
+    for (PooledConnection& connection : _pool) {
+        if (connection.inUse) {
+            if (connection.host == host) {
+                hostConnections++;
+            }
+            continue;
+        }
+
+        // Health check: only an idle, connected and quiet socket is worth keeping
+        bool open = connection.client && connection.client->connected();
+        if (open && (!config.keepAlive || now - connection.lastUsed > config.idleTimeout)) {
+            closeConnection(connection);
+            updateStats("connections_evicted");
+            open = false;
+        } else if (open && connection.client->available() > 0) {
+            // Bytes nobody asked for: the stream is out of step with the requests
+            closeConnection(connection);
+            updateStats("connections_stale");
+            open = false;
+        } else if (!open && connection.requests > 0) {
+            // The server closed its end while the socket sat idle
+            closeConnection(connection);
+            updateStats("connections_stale");
+        }
+
+        if (!open) {
+            if (empty == nullptr) {
+                empty = &connection;
+            }
+        } else if (connection.host == host) {
+            hostConnections++;
+            if (reusable == nullptr) {
+                reusable = &connection;
+            }
+        } else if (oldest == nullptr || now - connection.lastUsed > now - oldest->lastUsed) {
+            oldest = &connection;
+        }
+    }
+
+    PooledConnection* chosen = reusable;
+    if (chosen == nullptr && hostConnections < config.maxPerHost) {
+        chosen = empty;
+        if (chosen == nullptr && oldest != nullptr) {
+            chosen = oldest;
+            closeConnection(*chosen);
+            updateStats("connections_evicted");
+        }
+    }
+
+    if (chosen != nullptr) {
+        updateStats(chosen == reusable ? "connections_reused" : "connections_opened");
+        chosen->inUse = true;
+        chosen->host = host;
+    }
+
+    return chosen;
+}
+
+void HttpClientManager::releaseConnection(PooledConnection* connection, bool keepAlive) {
+    // end() only keeps the socket when reuse is on and the server allowed it
+    connection->http.end();
+    if (!keepAlive || !currentConfig()->keepAlive) {
+        closeConnection(*connection);
+    } else {
+        connection->requests++;
+    }
+
+    // Every waiter retries: the freed slot may suit any of their hosts
+    xSemaphoreTake(_poolMutex, portMAX_DELAY);
+    connection->lastUsed = millis();
+    connection->inUse = false;
+    for (SemaphoreHandle_t waiter : _waiters) {
+        xSemaphoreGive(waiter);
+    }
+    _waiters.clear();
+    xSemaphoreGive(_poolMutex);
+}
+
+void HttpClientManager::closeConnection(PooledConnection& connection) {
+    if (connection.client) {
+        connection.client->stop();
+    }
+    connection.requests = 0;
+}
+
+String HttpClientManager::hostKey(const String& url) {
+    int schemeEnd = url.indexOf("://");
+    if (schemeEnd <= 0) {
+        return "";
+    }
+
+    String scheme = url.substring(0, schemeEnd);
+    scheme.toLowerCase();
+
+    int authorityStart = schemeEnd + 3;
+    int authorityEnd = url.length();
+    for (char delimiter : {'/', '?', '#'}) {
+        int index = url.indexOf(delimiter, authorityStart);
+        if (index >= 0 && index < authorityEnd) {
+            authorityEnd = index;
+        }
+    }
+
+    String authority = url.substring(authorityStart, authorityEnd);
+    int credentials = authority.lastIndexOf('@');
+    if (credentials >= 0) {
+        authority = authority.substring(credentials + 1);
+    }
+    authority.toLowerCase();
+    if (authority.isEmpty()) {
+        return "";
+    }
+    if (authority.indexOf(':') < 0) {
+        authority += scheme == "https" ? ":443" : ":80";
+    }
+
+    return scheme + "://" + authority;
+}
+
+void HttpClientManager::applyHeaders(HTTPClient& http, const std::map<String, String>& headers) {
     for (const auto& header : headers) {
-        _httpClient.addHeader(header.first, header.second);
+        http.addHeader(header.first, header.second);
     }
 }
 
-std::map<String, String> HttpClientManager::getResponseHeaders() {
+std::map<String, String> HttpClientManager::getResponseHeaders(HTTPClient& http) {
     std::map<String, String> headers;
     
     // ESP32 HTTPClient doesn't provide easy access to all response headers
     // You might need to implement this differently based on your needs
     // This is a placeholder implementation
     
-    String server = _httpClient.header("Server");
+    String server = http.header("Server");
     if (!server.isEmpty()) {
         headers["Server"] = server;
     }
     
-    String contentType = _httpClient.header("Content-Type");
+    String contentType = http.header("Content-Type");
     if (!contentType.isEmpty()) {
         headers["Content-Type"] = contentType;
     }
     
-    String contentLength = _httpClient.header("Content-Length");
+    String contentLength = http.header("Content-Length");
     if (!contentLength.isEmpty()) {
         headers["Content-Length"] = contentLength;
     }
@@ -458,15 +737,35 @@ String HttpClientManager::methodToString(WebRequestMethod method) {
     }
 }
 
-void HttpClientManager::debug(const String& message) {
-    if (_debugEnabled) {
-        DEBUG_PRINTLN("[HttpClient] " + message);
-    }
-}
-
 void HttpClientManager::updateStats(const String& key, int increment) {
     // Thread-safe stats update with bounds checking
     if (key.length() > 0 && key.length() < 64) { // Prevent potential string corruption
+        xSemaphoreTake(_stateMutex, portMAX_DELAY);
         _stats[key] += increment;
+        xSemaphoreGive(_stateMutex);
+    }
+}
+
+void HttpClientManager::setLastError(const String& error) {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    _lastError = error;
+    xSemaphoreGive(_stateMutex);
+}
+
+void HttpClientManager::beginActivity() {
+    // Concurrent requests share one boost; the clock from before the first is restored
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    if (_inFlight++ == 0) {
+        _idleCpu = __lastCPUSet;
+        setCPU(CPU_HIGH);
+    }
+    xSemaphoreGive(_stateMutex);
+}
+
+void HttpClientManager::endActivity() {
+    xSemaphoreTake(_stateMutex, portMAX_DELAY);
+    if (_inFlight > 0 && --_inFlight == 0) {
+        setCPU(_idleCpu);
     }
+    xSemaphoreGive(_stateMutex);
 }
@@ -8,9 +8,17 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <map>
+#include <memory>
 #include <vector>
 #include "cpu_freq.h"
 
+// Pooled connections shared by all hosts, and so the number of requests in flight
+#define HTTP_POOL_SIZE 4
+// Pooled connections one host may hold at a time
+#define HTTP_POOL_MAX_PER_HOST 2
+// Idle keep-alive connections older than this are closed instead of reused
+#define HTTP_POOL_IDLE_TIMEOUT_MS 10000
+
 /**
  * @brief HTTP response structure
  */
@@ -33,9 +41,12 @@ struct HttpConfig {
     unsigned long connectTimeout;   // Connection timeout in milliseconds
     bool followRedirects;          // Whether to follow HTTP redirects
     int maxRedirects;              // Maximum number of redirects to follow
-    bool verifySsl;                // Whether to verify SSL certificates
+    bool verifySsl;                // Whether to verify SSL certificates; needs setCACertificate()
     String userAgent;              // User agent string
     std::map<String, String> defaultHeaders; // Default headers for all requests
+    bool keepAlive;                // Whether to keep connections open between requests
+    unsigned long idleTimeout;     // Idle time after which a pooled connection is closed
+    int maxPerHost;                // Maximum pooled connections per host
     
     HttpConfig() : 
         timeout(30000), 
@@ -43,7 +54,29 @@ struct HttpConfig {
         followRedirects(true), 
         maxRedirects(5), 
         verifySsl(true),
-        userAgent("ESP32-S3-HttpClient/1.0") {}
+        userAgent("ESP32-S3-HttpClient/1.0"),
+        keepAlive(true),
+        idleTimeout(HTTP_POOL_IDLE_TIMEOUT_MS),
+        maxPerHost(HTTP_POOL_MAX_PER_HOST) {}
+};
+
+/**
+ * @brief One slot of the keep-alive connection pool
+ *
+ * The client is declared before the HTTPClient so it outlives it; the
+ * HTTPClient destructor still touches the socket it was last bound to.
+ */
+struct PooledConnection {
+    std::unique_ptr<WiFiClient> client;
+    HTTPClient http;
+    String host;                   // scheme://host:port the socket is connected to
+    bool secure;
+    std::shared_ptr<const String> caCert; // CA the TLS client verifies against, kept alive while in use
+    bool inUse;
+    unsigned long lastUsed;
+    uint32_t requests;             // Requests served on the current socket
+    
+    PooledConnection() : secure(false), inUse(false), lastUsed(0), requests(0) {}
 };
 
 /**
@@ -94,6 +127,17 @@ public:
      */
     void setBearerToken(const String& token);
 
+    /**
+     * @brief Set the root CA certificate HTTPS servers are verified against
+     * 
+     * Only used while config.verifySsl is true. Without a CA, HTTPS
+     * connections are encrypted but the server is not authenticated, as
+     * with HTTPClient::begin(url).
+     * 
+     * @param caCert PEM encoded certificate, copied; nullptr or empty to clear
+     */
+    void setCACertificate(const char* caCert);
+
     /**
      * @brief Set custom headers for all requests
      * 
@@ -176,16 +220,22 @@ public:
     /**
      * @brief Make a generic HTTP request
      * 
+     * Up to HTTP_POOL_SIZE requests run at once, each on its own pooled
+     * connection; further callers wait for one to be released.
+     * 
      * @param method HTTP method
      * @param url Request URL
      * @param body Request body (empty for GET, DELETE, etc.)
      * @param contentType Content-Type header value
      * @param headers Optional additional headers
+     * @param timeout Bound in milliseconds on waiting for a connection, connecting
+     *                and each read; 0 uses the configured timeout
      * @return HttpResponse Response structure
      */
     HttpResponse request(WebRequestMethod method, const String& url, const String& body = "",
                         const String& contentType = "application/json",
-                        const std::map<String, String>& headers = {});
+                        const std::map<String, String>& headers = {},
+                        unsigned long timeout = 0);
 
     /**
      * @brief Make a GET request and parse JSON response
@@ -268,9 +318,20 @@ public:
      */
     void setDebugEnabled(bool enabled);
 
+    /**
+     * @brief Close every idle pooled connection
+     */
+    void closeIdleConnections();
+
 private:
-    HTTPClient _httpClient;
-    HttpConfig _config;
+    PooledConnection _pool[HTTP_POOL_SIZE];
+    SemaphoreHandle_t _poolMutex;
+    std::vector<SemaphoreHandle_t> _waiters; // Requests waiting for a release, guarded by _poolMutex
+    SemaphoreHandle_t _stateMutex; // Guards configuration, credentials, statistics, last error and CPU bookkeeping
+    int _inFlight;
+    cpu_freq _idleCpu;
+    std::shared_ptr<const HttpConfig> _config; // Replaced, never modified, so requests can keep a copy
+    std::shared_ptr<const String> _caCert;
     String _lastError;
     bool _debugEnabled;
     
@@ -282,27 +343,99 @@ private:
     std::map<String, int> _stats;
     
     /**
-     * @brief Setup HTTP client for request
+     * @brief Configuration in effect for a request
+     * 
+     * @return std::shared_ptr<const HttpConfig> Current configuration
+     */
+    std::shared_ptr<const HttpConfig> currentConfig();
+    
+    /**
+     * @brief Replace the configuration with a modified copy
+     * 
+     * @param change Applied to the copy
+     */
+    void updateConfig(std::function<void(HttpConfig&)> change);
+    
+    /**
+     * @brief Setup a pooled HTTP client for request
      * 
      * @param url Request URL
      * @param headers Request headers
-     * @return true if setup successful
+     * @param timeout Request timeout in milliseconds
+     * @param error Set to the reason when no connection is returned
+     * @return PooledConnection* Connection to use, nullptr on failure
      */
-    bool setupRequest(const String& url, const std::map<String, String>& headers);
+    PooledConnection* setupRequest(const String& url, const std::map<String, String>& headers,
+                                   unsigned long timeout, String& error);
+    
+    /**
+     * @brief Reserve a pooled connection for the host of a URL
+     * 
+     * Waits while the pool is full or the host is at its connection limit,
+     * woken by each release. A waiting request holds nothing, so requests to
+     * other hosts can still take free slots.
+     * 
+     * @param url Request URL
+     * @param timeout Longest time to wait in milliseconds
+     * @param config Configuration of the request
+     * @param error Set to the reason when no connection is returned
+     * @return PooledConnection* Reserved connection, nullptr on failure
+     */
+    PooledConnection* acquireConnection(const String& url, unsigned long timeout,
+                                        const HttpConfig& config, String& error);
+    
+    /**
+     * @brief Pick and reserve a pool slot for a host without waiting
+     * 
+     * Prefers an idle, healthy socket to the same host, then an empty slot,
+     * then evicts the least recently used idle connection. The caller holds
+     * _poolMutex.
+     * 
+     * @param host Pool key from hostKey()
+     * @param config Configuration of the request
+     * @return PooledConnection* Reserved connection, nullptr if the pool is full
+     *                           or the host is at its limit
+     */
+    PooledConnection* takeConnection(const String& host, const HttpConfig& config);
+    
+    /**
+     * @brief Return a connection to the pool and wake waiting requests
+     * 
+     * @param connection Connection taken from acquireConnection
+     * @param keepAlive Whether the socket may be reused
+     */
+    void releaseConnection(PooledConnection* connection, bool keepAlive);
+    
+    /**
+     * @brief Close the socket of a pooled connection
+     * 
+     * @param connection Pool slot to close
+     */
+    void closeConnection(PooledConnection& connection);
+    
+    /**
+     * @brief Pool key for a URL
+     * 
+     * @param url Request URL
+     * @return String scheme://host:port, empty if the URL cannot be parsed
+     */
+    String hostKey(const String& url);
     
     /**
      * @brief Apply headers to HTTP client
      * 
+     * @param http Client to add the headers to
      * @param headers Headers to apply
      */
-    void applyHeaders(const std::map<String, String>& headers);
+    void applyHeaders(HTTPClient& http, const std::map<String, String>& headers);
     
     /**
      * @brief Get response headers from HTTP client
      * 
+     * @param http Client holding the response
      * @return std::map<String, String> Response headers
      */
-    std::map<String, String> getResponseHeaders();
+    std::map<String, String> getResponseHeaders(HTTPClient& http);
     
     /**
      * @brief Convert HTTP method enum to string
@@ -312,13 +445,6 @@ private:
      */
     String methodToString(WebRequestMethod method);
     
-    /**
-     * @brief Log debug message
-     * 
-     * @param message Debug message
-     */
-    void debug(const String& message);
-    
     /**
      * @brief Update statistics
      * 
@@ -326,8 +452,23 @@ private:
      * @param increment Value to add
      */
     void updateStats(const String& key, int increment = 1);
+    
+    /**
+     * @brief Record the most recent error
+     * 
+     * @param error Error message
+     */
+    void setLastError(const String& error);
+    
+    /**
+     * @brief Raise the CPU clock while the first request is in flight
+     */
+    void beginActivity();
+    
+    /**
+     * @brief Restore the CPU clock once the last request has finished
+     */
+    void endActivity();
 };
 
-extern SemaphoreHandle_t httpClientMutex;
-
 #endif // HTTP_CLIENT_H
@@ -168,6 +168,10 @@ void IoTDeviceManager::setDeviceStatusCallback(std::function<void(const IoTDevic
     _discovery->setDeviceStatusCallback(callback);
 }
 
+void IoTDeviceManager::setScanCompleteCallback(std::function<void(int)> callback) {
+    _discovery->setScanCompleteCallback(callback);
+}
+
 JsonDocument IoTDeviceManager::getStatistics() const {
     JsonDocument stats = _discovery->getStatistics();
     
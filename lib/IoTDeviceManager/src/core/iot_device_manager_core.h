@@ -58,6 +58,7 @@ public:
     // Callbacks
     void setDeviceDiscoveredCallback(std::function<void(const IoTDevice&)> callback);
     void setDeviceStatusCallback(std::function<void(const IoTDevice&, bool)> callback);
+    void setScanCompleteCallback(std::function<void(int)> callback);
 
     // Statistics and utilities
     JsonDocument getStatistics() const;
@@ -26,7 +26,7 @@ DeviceDiscovery::~DeviceDiscovery() {
 
 void DeviceDiscovery::startDiscovery(unsigned long scanIntervalMs) {
     if (_discoveryEnabled) {
-        DEBUG_PRINTLN("DeviceDiscovery: Discovery already running");
+        LOG_WARNING("DeviceDiscovery: Discovery already running");
         return;
     }
     
@@ -44,7 +44,7 @@ void DeviceDiscovery::startDiscovery(unsigned long scanIntervalMs) {
         0
     );
     
-    DEBUG_PRINTF("DeviceDiscovery: Started discovery with %d ms interval\n", scanIntervalMs);
+    LOG_INFO("DeviceDiscovery: Started discovery with %lu ms interval", scanIntervalMs);
 }
 
 void DeviceDiscovery::stopDiscovery() {
@@ -57,11 +57,11 @@ void DeviceDiscovery::stopDiscovery() {
         _discoveryTaskHandle = nullptr;
     }
     
-    DEBUG_PRINTLN("DeviceDiscovery: Stopped discovery");
+    LOG_INFO("DeviceDiscovery: Stopped discovery");
 }
 
 int DeviceDiscovery::scanForDevices() {
-    DEBUG_PRINTLN("DeviceDiscovery: Starting device scan...");
+    LOG_DEBUG("DeviceDiscovery: Starting device scan...");
     
     unsigned long scanStart = millis();
     int newDevices = 0;
@@ -69,11 +69,11 @@ int DeviceDiscovery::scanForDevices() {
     // Get current connected clients from WiFiManager
     std::vector<ClientInfo> clients = _wifiManager->getConnectedClients();
     
-    DEBUG_PRINTF("DeviceDiscovery: Found %d connected clients\n", clients.size());
+    LOG_DEBUG("DeviceDiscovery: Found %u connected clients", (unsigned)clients.size());
     
     for (const auto& client : clients) {
         if (client.ipAddress == "0.0.0.0") {
-            DEBUG_PRINTF("DeviceDiscovery: Skipping client with invalid IP: %s\n", client.macAddress.c_str());
+            LOG_DEBUG("DeviceDiscovery: Skipping client with invalid IP: %s", client.macAddress.c_str());
             continue;
         }
         
@@ -99,14 +99,14 @@ int DeviceDiscovery::scanForDevices() {
             newDevice.lastSeen = millis();
             newDevice.baseUrl = "http://" + client.ipAddress;
             
-            DEBUG_PRINTF("DeviceDiscovery: New device discovered - %s (%s)\n", 
+            LOG_INFO("DeviceDiscovery: New device discovered - %s (%s)", 
                         newDevice.ipAddress.c_str(), newDevice.macAddress.c_str());
             
             // Check if device has HTTP server
             newDevice.hasHttpServer = checkHttpServer(newDevice.ipAddress);
             
             if (newDevice.hasHttpServer) {
-                DEBUG_PRINTF("DeviceDiscovery: Device %s has HTTP server, probing...\n", 
+                LOG_DEBUG("DeviceDiscovery: Device %s has HTTP server, probing...", 
                             newDevice.ipAddress.c_str());
                 
                 // Probe device to determine type and capabilities
@@ -121,15 +121,15 @@ int DeviceDiscovery::scanForDevices() {
                         _deviceDiscoveredCallback(newDevice);
                     }
                     
-                    DEBUG_PRINTF("DeviceDiscovery: Device %s identified as %s\n",
+                    LOG_INFO("DeviceDiscovery: Device %s identified as %s",
                                 newDevice.ipAddress.c_str(), 
                                 DeviceTypeUtils::deviceTypeToString(newDevice.type).c_str());
                 } else {
-                    DEBUG_PRINTF("DeviceDiscovery: Failed to probe device %s\n", 
+                    LOG_WARNING("DeviceDiscovery: Failed to probe device %s", 
                                 newDevice.ipAddress.c_str());
                 }
             } else {
-                DEBUG_PRINTF("DeviceDiscovery: Device %s has no HTTP server\n", 
+                LOG_DEBUG("DeviceDiscovery: Device %s has no HTTP server", 
                             newDevice.ipAddress.c_str());
             }
         } else {
@@ -167,14 +167,18 @@ int DeviceDiscovery::scanForDevices() {
     _totalScans++;
     _lastScanDuration = millis() - scanStart;
     
-    DEBUG_PRINTF("DeviceDiscovery: Scan completed in %d ms. Found %d new devices\n",
+    LOG_DEBUG("DeviceDiscovery: Scan completed in %lu ms. Found %d new devices",
                 _lastScanDuration, newDevices);
     
+    if (_scanCompleteCallback) {
+        _scanCompleteCallback(newDevices);
+    }
+    
     return newDevices;
 }
 
 void DeviceDiscovery::startManualScan() {
-    DEBUG_PRINTLN("DeviceDiscovery: Manual scan requested");
+    LOG_INFO("DeviceDiscovery: Manual scan requested");
     _lastDiscoveryScan = 0; // Force immediate scan on next update
 }
 
@@ -185,7 +189,7 @@ bool DeviceDiscovery::isDiscoveryActive() const {
 void DeviceDiscovery::registerDriver(DeviceDriver* driver) {
     if (driver != nullptr) {
         _drivers.push_back(driver);
-        DEBUG_PRINTF("DeviceDiscovery: Registered driver: %s\n", driver->getDriverName().c_str());
+        LOG_INFO("DeviceDiscovery: Registered driver: %s", driver->getDriverName().c_str());
     }
 }
 
@@ -210,8 +214,12 @@ void DeviceDiscovery::setDeviceStatusCallback(std::function<void(const IoTDevice
     _deviceStatusCallback = callback;
 }
 
+void DeviceDiscovery::setScanCompleteCallback(std::function<void(int)> callback) {
+    _scanCompleteCallback = callback;
+}
+
 bool DeviceDiscovery::checkHttpServer(const String& ipAddress) {
-    DEBUG_PRINTF("DeviceDiscovery: Checking HTTP server on %s:80\n", ipAddress.c_str());
+    LOG_DEBUG("DeviceDiscovery: Checking HTTP server on %s:80", ipAddress.c_str());
     
     // Use HttpClientManager to check if port 80 is open
     String testUrl = "http://" + ipAddress + "/";
@@ -220,30 +228,30 @@ bool DeviceDiscovery::checkHttpServer(const String& ipAddress) {
     
     // Any response (even 404) indicates an HTTP server is running
     if (response.statusCode > 0) {
-        DEBUG_PRINTF("DeviceDiscovery: HTTP server detected on %s (status: %d)\n", 
+        LOG_DEBUG("DeviceDiscovery: HTTP server detected on %s (status: %d)", 
                     ipAddress.c_str(), response.statusCode);
         return true;
     }
     
-    DEBUG_PRINTF("DeviceDiscovery: No HTTP server on %s\n", ipAddress.c_str());
+    LOG_DEBUG("DeviceDiscovery: No HTTP server on %s", ipAddress.c_str());
     return false;
 }
 
 bool DeviceDiscovery::probeDevice(IoTDevice& device) {
-    DEBUG_PRINTF("DeviceDiscovery: Probing device %s\n", device.ipAddress.c_str());
+    LOG_DEBUG("DeviceDiscovery: Probing device %s", device.ipAddress.c_str());
     
     // Try each registered driver to see which one can handle this device
     for (auto* driver : _drivers) {
-        DEBUG_PRINTF("DeviceDiscovery: Trying driver %s\n", driver->getDriverName().c_str());
+        LOG_DEBUG("DeviceDiscovery: Trying driver %s", driver->getDriverName().c_str());
         
         if (driver->probe(device, *_httpClient)) {
-            DEBUG_PRINTF("DeviceDiscovery: Device %s handled by driver %s\n",
+            LOG_INFO("DeviceDiscovery: Device %s handled by driver %s",
                         device.ipAddress.c_str(), driver->getDriverName().c_str());
             return true;
         }
     }
     
-    DEBUG_PRINTF("DeviceDiscovery: No driver could handle device %s\n", device.ipAddress.c_str());
+    LOG_WARNING("DeviceDiscovery: No driver could handle device %s", device.ipAddress.c_str());
     return false;
 }
 
@@ -261,7 +269,7 @@ void DeviceDiscovery::updateDeviceStatus(IoTDevice& device, bool isOnline) {
         device.isOnline = isOnline;
         device.lastSeen = millis();
         
-        DEBUG_PRINTF("DeviceDiscovery: Device %s (%s) is now %s\n",
+        LOG_INFO("DeviceDiscovery: Device %s (%s) is now %s",
                     device.name.c_str(), device.ipAddress.c_str(),
                     isOnline ? "online" : "offline");
         
@@ -274,7 +282,7 @@ void DeviceDiscovery::updateDeviceStatus(IoTDevice& device, bool isOnline) {
 void DeviceDiscovery::discoveryTask(void* parameter) {
     DeviceDiscovery* discovery = static_cast<DeviceDiscovery*>(parameter);
     
-    DEBUG_PRINTLN("DeviceDiscovery: Discovery task started");
+    LOG_INFO("DeviceDiscovery: Discovery task started");
     
     while (discovery->_discoveryEnabled) {
         unsigned long now = millis();
@@ -288,6 +296,6 @@ void DeviceDiscovery::discoveryTask(void* parameter) {
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
-    DEBUG_PRINTLN("DeviceDiscovery: Discovery task ended");
+    LOG_INFO("DeviceDiscovery: Discovery task ended");
     vTaskDelete(NULL);
 }
@@ -67,6 +67,11 @@ public:
      * @brief Set device status change callback
      */
     void setDeviceStatusCallback(std::function<void(const IoTDevice&, bool)> callback);
+    
+    /**
+     * @brief Set callback run after every scan, with the number of new devices
+     */
+    void setScanCompleteCallback(std::function<void(int)> callback);
 
 private:
     WiFiManager* _wifiManager;
@@ -87,6 +92,7 @@ private:
     // Callbacks
     std::function<void(const IoTDevice&)> _deviceDiscoveredCallback;
     std::function<void(const IoTDevice&, bool)> _deviceStatusCallback;
+    std::function<void(int)> _scanCompleteCallback;
     
     /**
      * @brief Check if device has HTTP server
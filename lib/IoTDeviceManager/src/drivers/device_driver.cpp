@@ -3,12 +3,16 @@
 
 bool DeviceDriver::checkEndpoint(const String& baseUrl, const String& endpoint, HttpClientManager& httpClient) {
     String url = baseUrl + endpoint;
-    HttpResponse response = httpClient.get(url);
+    HttpResponse response = httpClient.request(HTTP_GET, url, "", "", {}, DEVICE_PROBE_TIMEOUT_MS);
     
     // Consider 200, 401, 403 as valid responses (endpoint exists)
     return (response.statusCode == 200 || response.statusCode == 401 || response.statusCode == 403);
 }
 
+HttpResponse DeviceDriver::deviceRequest(WebRequestMethod method, const String& url, HttpClientManager& httpClient) {
+    return httpClient.request(method, url, "", method == HTTP_POST ? "application/json" : "", {}, DEVICE_REQUEST_TIMEOUT_MS);
+}
+
 void DeviceDriver::setDeviceProperties(IoTDevice& device, DeviceType type, uint32_t capabilities, const String& name) {
     device.type = type;
     device.capabilities = capabilities;
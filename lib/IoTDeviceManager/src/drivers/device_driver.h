@@ -5,6 +5,11 @@
 #include "httpclient.h"
 #include <ArduinoJson.h>
 
+// Endpoint probes give up quickly so a silent host does not hold a connection
+#define DEVICE_PROBE_TIMEOUT_MS 3000
+// Info and command calls; bounds how long one holds a route worker
+#define DEVICE_REQUEST_TIMEOUT_MS 5000
+
 /**
  * @brief Device driver interface for handling device-specific operations
  */
@@ -50,6 +55,11 @@ protected:
      */
     bool checkEndpoint(const String& baseUrl, const String& endpoint, HttpClientManager& httpClient);
     
+    /**
+     * @brief Helper for info and command calls, bounded by DEVICE_REQUEST_TIMEOUT_MS
+     */
+    HttpResponse deviceRequest(WebRequestMethod method, const String& url, HttpClientManager& httpClient);
+    
     /**
      * @brief Helper function to set common device properties
      */
@@ -54,7 +54,7 @@ JsonDocument ESP32CameraDriver::getDeviceInfo(const IoTDevice& device, HttpClien
     }
     
     // Try to get camera status
-    HttpResponse response = httpClient.get(device.baseUrl + "/api/v1/camera/status");
+    HttpResponse response = deviceRequest(HTTP_GET, device.baseUrl + "/api/v1/camera/status", httpClient);
     if (response.statusCode == 200) {
         JsonDocument cameraStatus;
         if (deserializeJson(cameraStatus, response.body) == DeserializationError::Ok) {
@@ -76,17 +76,17 @@ bool ESP32CameraDriver::executeCommand(const IoTDevice& device, const String& co
             url += "?quality=" + params["quality"].as<String>();
         }
         
-        HttpResponse response = httpClient.post(url, "");
+        HttpResponse response = deviceRequest(HTTP_POST, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     else if (command == "start_stream") {
         String url = device.baseUrl + "/api/v1/camera/stream";
-        HttpResponse response = httpClient.post(url, "");
+        HttpResponse response = deviceRequest(HTTP_POST, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     else if (command == "stop_stream") {
         String url = device.baseUrl + "/api/v1/camera/stream";
-        HttpResponse response = httpClient.del(url);
+        HttpResponse response = deviceRequest(HTTP_DELETE, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     
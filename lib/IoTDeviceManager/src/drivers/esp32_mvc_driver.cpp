@@ -60,7 +60,7 @@ JsonDocument ESP32MVCDriver::getDeviceInfo(const IoTDevice& device, HttpClientMa
     }
     
     // Try to get system status
-    HttpResponse response = httpClient.get(device.baseUrl + "/api/v1/system/stats");
+    HttpResponse response = deviceRequest(HTTP_GET, device.baseUrl + "/api/v1/system/stats", httpClient);
     if (response.statusCode == 200) {
         JsonDocument systemStats;
         if (deserializeJson(systemStats, response.body) == DeserializationError::Ok) {
@@ -78,17 +78,17 @@ bool ESP32MVCDriver::executeCommand(const IoTDevice& device, const String& comma
     
     if (command == "system_restart") {
         String url = device.baseUrl + "/api/v1/system/restart";
-        HttpResponse response = httpClient.post(url, "");
+        HttpResponse response = deviceRequest(HTTP_POST, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     else if (command == "get_wifi_status") {
         String url = device.baseUrl + "/api/wifi/status";
-        HttpResponse response = httpClient.get(url);
+        HttpResponse response = deviceRequest(HTTP_GET, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     else if (command == "get_iot_devices") {
         String url = device.baseUrl + "/api/v1/iot/devices";
-        HttpResponse response = httpClient.get(url);
+        HttpResponse response = deviceRequest(HTTP_GET, url, httpClient);
         return response.statusCode >= 200 && response.statusCode < 300;
     }
     
@@ -87,7 +87,7 @@ JsonDocument GenericRESTDriver::getDeviceInfo(const IoTDevice& device, HttpClien
     std::vector<String> infoEndpoints = {"/info", "/status", "/api/info", "/device"};
     
     for (const String& endpoint : infoEndpoints) {
-        HttpResponse response = httpClient.get(device.baseUrl + endpoint);
+        HttpResponse response = deviceRequest(HTTP_GET, device.baseUrl + endpoint, httpClient);
         if (response.statusCode == 200) {
             JsonDocument deviceInfo;
             if (deserializeJson(deviceInfo, response.body) == DeserializationError::Ok) {
@@ -109,7 +109,7 @@ bool GenericRESTDriver::executeCommand(const IoTDevice& device, const String& co
         std::vector<String> statusEndpoints = {"/status", "/api/status", "/health"};
         
         for (const String& endpoint : statusEndpoints) {
-            HttpResponse response = httpClient.get(device.baseUrl + endpoint);
+            HttpResponse response = deviceRequest(HTTP_GET, device.baseUrl + endpoint, httpClient);
             if (response.statusCode >= 200 && response.statusCode < 300) {
                 return true;
             }
@@ -120,7 +120,7 @@ bool GenericRESTDriver::executeCommand(const IoTDevice& device, const String& co
         std::vector<String> infoEndpoints = {"/info", "/api/info", "/device"};
         
         for (const String& endpoint : infoEndpoints) {
-            HttpResponse response = httpClient.get(device.baseUrl + endpoint);
+            HttpResponse response = deviceRequest(HTTP_GET, device.baseUrl + endpoint, httpClient);
             if (response.statusCode >= 200 && response.statusCode < 300) {
                 return true;
             }
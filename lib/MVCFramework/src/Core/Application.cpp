@@ -4,6 +4,7 @@
 #include "../Routing/Router.h"
 #include "../Http/Request.h"
 #include "../Http/Response.h"
+#include "../Http/Middleware.h"
 #include "../Database/CsvDatabase.h"
 #include "../Database/Model.h"
 #include <SPIFFS.h>
@@ -89,16 +90,16 @@ void Application::registerProviders() {
 }
 
 void Application::registerMiddleware() {
-    // Register core middleware
-    // Note: These middleware classes need to be implemented
+    // Register core middleware. These are opt-in: routes naming one that is
+    // not registered are reported at router init and run without it.
     // router->registerMiddleware("cors", std::make_shared<CorsMiddleware>());
     // router->registerMiddleware("auth", std::make_shared<AuthMiddleware>());
     // router->registerMiddleware("logging", std::make_shared<LoggingMiddleware>());
     // router->registerMiddleware("json", std::make_shared<JsonMiddleware>());
     // router->registerMiddleware("ratelimit", std::make_shared<RateLimitMiddleware>());
     
-    // For now, just register a basic middleware
-    Serial.println("Middleware registration placeholder - implement custom middleware classes as needed");
+    // Response cache for the polled GET routes ("cache:<seconds>,<tag>")
+    router->registerMiddleware("cache", std::make_shared<CacheMiddleware>());
 }
 
 void Application::registerRoutes() {
@@ -115,4 +116,22 @@ void Application::registerRoutes() {
         
         return Response(request.getServerRequest()).json(doc);
     });
+    
+    // Per-route hit counts and latency histograms; ?format=prometheus (or an
+    // Accept: text/plain scraper) gets the Prometheus text exposition format
+    router->get("/metrics", [this](Request& request) -> Response {
+        String format = request.get("format");
+        bool prometheus = format == "prometheus" ||
+                          (format.isEmpty() && request.header("Accept").indexOf("text/plain") >= 0);
+        
+        if (prometheus) {
+            return Response(request.getServerRequest())
+                .contentType("text/plain; version=0.0.4")
+                .content(router->metricsPrometheus());
+        }
+        
+        JsonDocument doc;
+        router->metricsJson(doc);
+        return Response(request.getServerRequest()).json(doc);
+    }).name("metrics");
 }
@@ -1,6 +1,32 @@
 #include "CsvDatabase.h"
 
-CsvDatabase::CsvDatabase() {
+namespace {
+// Holds the database lock for the rest of the enclosing scope
+class TableLock {
+private:
+    SemaphoreHandle_t handle;
+
+public:
+    explicit TableLock(SemaphoreHandle_t handle) : handle(handle) {
+        xSemaphoreTakeRecursive(handle, portMAX_DELAY);
+    }
+    ~TableLock() {
+        xSemaphoreGiveRecursive(handle);
+    }
+};
+
+// Next line of content starting at offset, trimmed; advances offset past it
+String nextLine(const String& content, size_t& offset) {
+    int end = content.indexOf('\n', offset);
+    if (end < 0) end = content.length();
+    String line = content.substring(offset, end);
+    line.trim();
+    offset = end + 1;
+    return line;
+}
+}
+
+CsvDatabase::CsvDatabase() : lock(xSemaphoreCreateRecursiveMutex()), snapshotLock(xSemaphoreCreateMutex()) {
     // Ensure database directory exists
     if (!SPIFFS.exists(basePath)) {
         // Create directory structure (SPIFFS doesn't have mkdir, so we create a dummy file)
@@ -98,6 +124,7 @@ bool CsvDatabase::tableExists(const String& tableName) const {
 }
 
 bool CsvDatabase::createTable(const String& tableName, const std::vector<String>& columns) {
+    TableLock guard(lock);
     if (tableExists(tableName)) {
         return false; // Table already exists
     }
@@ -112,37 +139,36 @@ bool CsvDatabase::createTable(const String& tableName, const std::vector<String>
         }
     }
     
-    String headerLine = buildCsvLine(headers);
-    return writeToFile(getTablePath(tableName), headerLine + "\n");
+    String content = buildCsvLine(headers) + "\n";
+    touchTable(tableName);
+    if (!writeToFile(getTablePath(tableName), content)) {
+        return false;
+    }
+    storeSnapshot(tableName, std::make_shared<const String>(content));
+    return true;
 }
 
 bool CsvDatabase::dropTable(const String& tableName) {
+    TableLock guard(lock);
     if (!tableExists(tableName)) {
         return false;
     }
     
+    touchTable(tableName);
+    storeSnapshot(tableName, nullptr);
     return SPIFFS.remove(getTablePath(tableName));
 }
 
 std::vector<String> CsvDatabase::getTableColumns(const String& tableName) const {
     std::vector<String> columns;
     
-    if (!tableExists(tableName)) {
+    std::shared_ptr<const String> content = loadTable(tableName);
+    if (!content || content->length() == 0) {
         return columns;
     }
     
-    File file = SPIFFS.open(getTablePath(tableName), "r");
-    if (!file) {
-        return columns;
-    }
-    
-    if (file.available()) {
-        String headerLine = file.readStringUntil('\n');
-        headerLine.trim();
-        columns = parseCsvLine(headerLine);
-    }
-    
-    file.close();
+    size_t offset = 0;
+    columns = parseCsvLine(nextLine(*content, offset));
     return columns;
 }
 
@@ -151,27 +177,21 @@ std::vector<std::map<String, String>> CsvDatabase::select(const String& tableNam
     
     std::vector<std::map<String, String>> results;
     
-    if (!tableExists(tableName)) {
-        return results;
-    }
-    
-    File file = SPIFFS.open(getTablePath(tableName), "r");
-    if (!file) {
+    std::shared_ptr<const String> content = loadTable(tableName);
+    if (!content) {
         return results;
     }
     
     // Read header
+    size_t offset = 0;
     std::vector<String> columns;
-    if (file.available()) {
-        String headerLine = file.readStringUntil('\n');
-        headerLine.trim();
-        columns = parseCsvLine(headerLine);
+    if (offset < content->length()) {
+        columns = parseCsvLine(nextLine(*content, offset));
     }
     
     // Read data rows
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        line.trim();
+    while (offset < content->length()) {
+        String line = nextLine(*content, offset);
         
         if (line.length() == 0) continue;
         
@@ -189,7 +209,6 @@ std::vector<std::map<String, String>> CsvDatabase::select(const String& tableNam
         }
     }
     
-    file.close();
     return results;
 }
 
@@ -211,6 +230,7 @@ std::map<String, String> CsvDatabase::findWhere(const String& tableName,
 }
 
 bool CsvDatabase::insert(const String& tableName, const std::map<String, String>& data) {
+    TableLock guard(lock);
     if (!tableExists(tableName)) {
         return false;
     }
@@ -238,6 +258,7 @@ bool CsvDatabase::insert(const String& tableName, const std::map<String, String>
     }
     
     // Append to file
+    touchTable(tableName);
     File file = SPIFFS.open(getTablePath(tableName), "a");
     if (!file) {
         return false;
@@ -247,11 +268,16 @@ bool CsvDatabase::insert(const String& tableName, const std::map<String, String>
     file.println(line);
     file.close();
     
+    std::shared_ptr<const String> previous = findSnapshot(tableName);
+    if (previous) {
+        storeSnapshot(tableName, std::make_shared<const String>(*previous + line + "\r\n"));
+    }
     return true;
 }
 
 bool CsvDatabase::update(const String& tableName, const String& id, 
     const std::map<String, String>& data) {
+    TableLock guard(lock);
     
     if (!tableExists(tableName)) {
         return false;
@@ -294,10 +320,16 @@ bool CsvDatabase::update(const String& tableName, const String& id,
         content += buildCsvLine(values) + "\n";
     }
     
-    return writeToFile(getTablePath(tableName), content);
+    touchTable(tableName);
+    if (!writeToFile(getTablePath(tableName), content)) {
+        return false;
+    }
+    storeSnapshot(tableName, std::make_shared<const String>(content));
+    return true;
 }
 
 bool CsvDatabase::delete_(const String& tableName, const String& id) {
+    TableLock guard(lock);
     if (!tableExists(tableName)) {
         return false;
     }
@@ -338,7 +370,12 @@ bool CsvDatabase::delete_(const String& tableName, const String& id) {
         content += buildCsvLine(values) + "\n";
     }
     
-    return writeToFile(getTablePath(tableName), content);
+    touchTable(tableName);
+    if (!writeToFile(getTablePath(tableName), content)) {
+        return false;
+    }
+    storeSnapshot(tableName, std::make_shared<const String>(content));
+    return true;
 }
 
 int CsvDatabase::getNextId(const String& tableName) const {
@@ -385,7 +422,57 @@ std::vector<String> CsvDatabase::getTables() const {
     return tables;
 }
 
+uint32_t CsvDatabase::getTableVersion(const String& tableName) const {
+    xSemaphoreTake(snapshotLock, portMAX_DELAY);
+    auto it = tableVersions.find(tableName);
+    uint32_t version = it != tableVersions.end() ? it->second : 0;
+    xSemaphoreGive(snapshotLock);
+    return version;
+}
+
+void CsvDatabase::touchTable(const String& tableName) const {
+    xSemaphoreTake(snapshotLock, portMAX_DELAY);
+    tableVersions[tableName]++;
+    xSemaphoreGive(snapshotLock);
+}
+
+std::shared_ptr<const String> CsvDatabase::findSnapshot(const String& tableName) const {
+    xSemaphoreTake(snapshotLock, portMAX_DELAY);
+    auto it = snapshots.find(tableName);
+    std::shared_ptr<const String> content = it != snapshots.end() ? it->second : nullptr;
+    xSemaphoreGive(snapshotLock);
+    return content;
+}
+
+void CsvDatabase::storeSnapshot(const String& tableName, std::shared_ptr<const String> content) const {
+    xSemaphoreTake(snapshotLock, portMAX_DELAY);
+    if (content) {
+        snapshots[tableName] = content;
+    } else {
+        snapshots.erase(tableName);
+    }
+    xSemaphoreGive(snapshotLock);
+}
+
+std::shared_ptr<const String> CsvDatabase::loadTable(const String& tableName) const {
+    std::shared_ptr<const String> content = findSnapshot(tableName);
+    if (content) {
+        return content;
+    }
+    
+    // First read of this table: load it between writes, then serve from memory
+    TableLock guard(lock);
+    content = findSnapshot(tableName);
+    if (content || !tableExists(tableName)) {
+        return content;
+    }
+    content = std::make_shared<const String>(readFromFile(getTablePath(tableName)));
+    storeSnapshot(tableName, content);
+    return content;
+}
+
 bool CsvDatabase::backup(const String& tableName) const {
+    TableLock guard(lock);
     if (!tableExists(tableName)) {
         return false;
     }
@@ -395,13 +482,19 @@ bool CsvDatabase::backup(const String& tableName) const {
 }
 
 bool CsvDatabase::restore(const String& tableName) const {
+    TableLock guard(lock);
     String backupPath = getBackupPath(tableName);
     if (!SPIFFS.exists(backupPath)) {
         return false;
     }
     
     String content = readFromFile(backupPath);
-    return writeToFile(getTablePath(tableName), content);
+    touchTable(tableName);
+    if (!writeToFile(getTablePath(tableName), content)) {
+        return false;
+    }
+    storeSnapshot(tableName, std::make_shared<const String>(content));
+    return true;
 }
 
 bool CsvDatabase::writeToFile(const String& filePath, const String& content) const {
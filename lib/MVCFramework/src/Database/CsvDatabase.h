@@ -5,10 +5,20 @@
 #include <SPIFFS.h>
 #include <vector>
 #include <map>
+#include <memory>
 
 class CsvDatabase {
 private:
     String basePath = "/database/";
+    // Bumped on every write so callers can tell when cached rows went stale
+    mutable std::map<String, uint32_t> tableVersions;
+    // Serializes writers. Recursive, since public operations call each other;
+    // a read-modify-write of a table file must not interleave with another's
+    SemaphoreHandle_t lock;
+    // Last written content of each table. Readers parse this snapshot and only
+    // hold snapshotLock to copy the pointer, so they never wait behind a write.
+    mutable std::map<String, std::shared_ptr<const String>> snapshots;
+    SemaphoreHandle_t snapshotLock;
     
     // Helper methods
     String escapeValue(const String& value) const;
@@ -46,10 +56,15 @@ public:
     // Statistics
     int count(const String& tableName, const std::map<String, String>& where = {}) const;
     std::vector<String> getTables() const;
+    uint32_t getTableVersion(const String& tableName) const;
     
 private:
     String getTablePath(const String& tableName) const;
     String getBackupPath(const String& tableName) const;
+    void touchTable(const String& tableName) const;
+    std::shared_ptr<const String> loadTable(const String& tableName) const;
+    std::shared_ptr<const String> findSnapshot(const String& tableName) const;
+    void storeSnapshot(const String& tableName, std::shared_ptr<const String> content) const;
     bool writeToFile(const String& filePath, const String& content) const;
     String readFromFile(const String& filePath) const;
     std::vector<String> readLines(const String& filePath) const;
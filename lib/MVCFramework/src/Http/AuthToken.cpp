@@ -0,0 +1,170 @@
+#include "AuthToken.h"
+#include <Crypto.h>
+#include <esp_timer.h>
+
+uint8_t AuthToken::secret[AUTH_TOKEN_SIGNATURE_SIZE];
+bool AuthToken::hasSecret = false;
+AuthToken::Entry AuthToken::cache[AUTH_TOKEN_CACHE_SIZE] = {};
+uint32_t AuthToken::useCounter = 0;
+portMUX_TYPE AuthToken::lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void AuthToken::ensureSecret() {
+    // Drawn lazily so the RNG is seeded by the radio by the time the first token is issued
+    portENTER_CRITICAL(&lock);
+    if (!hasSecret) {
+        for (size_t i = 0; i < sizeof(secret); i += 4) {
+            uint32_t value = esp_random();
+            memcpy(secret + i, &value, 4);
+        }
+        hasSecret = true;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void AuthToken::sign(const char* payload, size_t length, uint8_t* signature) {
+    ensureSecret();
+    SHA256HMAC hmac(secret, sizeof(secret));
+    hmac.doUpdate((const byte*)payload, length);
+    hmac.doFinal(signature);
+}
+
+uint32_t AuthToken::now() {
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+String AuthToken::issue(const String& subject, uint32_t ttlSeconds) {
+    String token = subject;
+    token += '.';
+    token += String(now() + ttlSeconds);
+
+    uint8_t signature[AUTH_TOKEN_SIGNATURE_SIZE];
+    sign(token.c_str(), token.length(), signature);
+
+    static const char digits[] = "0123456789abcdef";
+    token.reserve(token.length() + 1 + AUTH_TOKEN_SIGNATURE_SIZE * 2);
+    token += '.';
+    for (size_t i = 0; i < AUTH_TOKEN_SIGNATURE_SIZE; i++) {
+        token += digits[signature[i] >> 4];
+        token += digits[signature[i] & 0x0F];
+    }
+    return token;
+}
+
+bool AuthToken::verify(const String& token, String* subject) {
+    int signatureDot = token.lastIndexOf('.');
+    if (signatureDot <= 0 || token.length() - signatureDot - 1 != AUTH_TOKEN_SIGNATURE_SIZE * 2) {
+        return false;
+    }
+    int expiryDot = token.lastIndexOf('.', signatureDot - 1);
+    if (expiryDot <= 0 || expiryDot + 1 == signatureDot) {
+        return false;
+    }
+
+    uint32_t expires = 0;
+    for (int i = expiryDot + 1; i < signatureDot; i++) {
+        char c = token[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        expires = expires * 10 + (c - '0');
+    }
+    if (expires <= now()) {
+        return false;
+    }
+
+    uint8_t signature[AUTH_TOKEN_SIGNATURE_SIZE];
+    const char* hex = token.c_str() + signatureDot + 1;
+    for (size_t i = 0; i < AUTH_TOKEN_SIGNATURE_SIZE; i++) {
+        int high = hexValue(hex[i * 2]);
+        int low = hexValue(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        signature[i] = (high << 4) | low;
+    }
+
+    String name = token.substring(0, expiryDot);
+
+    if (!cached(name, expires, signature)) {
+        uint8_t expected[AUTH_TOKEN_SIGNATURE_SIZE];
+        sign(token.c_str(), signatureDot, expected);
+
+        // Constant-time compare so the signature cannot be guessed byte by byte
+        uint8_t difference = 0;
+        for (size_t i = 0; i < AUTH_TOKEN_SIGNATURE_SIZE; i++) {
+            difference |= expected[i] ^ signature[i];
+        }
+        if (difference != 0) {
+            return false;
+        }
+        remember(name, expires, signature);
+    }
+
+    if (subject) {
+        *subject = name;
+    }
+    return true;
+}
+
+// A hit must match the signature and the signed fields exactly, so the
+// cache only ever vouches for a token that was fully verified before
+bool AuthToken::cached(const String& subject, uint32_t expires, const uint8_t* signature) {
+    bool hit = false;
+
+    portENTER_CRITICAL(&lock);
+    for (Entry& entry : cache) {
+        if (entry.used && entry.expires == expires &&
+            memcmp(entry.signature, signature, AUTH_TOKEN_SIGNATURE_SIZE) == 0 &&
+            strcmp(entry.subject, subject.c_str()) == 0) {
+            entry.lastUsed = ++useCounter;
+            hit = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+
+    return hit;
+}
+
+void AuthToken::remember(const String& subject, uint32_t expires, const uint8_t* signature) {
+    if (subject.length() >= AUTH_TOKEN_MAX_SUBJECT) {
+        return;
+    }
+
+    uint32_t current = now();
+
+    portENTER_CRITICAL(&lock);
+    // Reuse a free or expired slot, otherwise evict the least recently used one
+    Entry* victim = &cache[0];
+    for (Entry& entry : cache) {
+        if (!entry.used || entry.expires <= current) {
+            victim = &entry;
+            break;
+        }
+        if (entry.lastUsed < victim->lastUsed) {
+            victim = &entry;
+        }
+    }
+    memcpy(victim->signature, signature, AUTH_TOKEN_SIGNATURE_SIZE);
+    memcpy(victim->subject, subject.c_str(), subject.length() + 1);
+    victim->expires = expires;
+    victim->lastUsed = ++useCounter;
+    victim->used = true;
+    portEXIT_CRITICAL(&lock);
+}
+
+String AuthToken::fromHeader(const String& authorization) {
+    if (!authorization.startsWith("Bearer ")) {
+        return "";
+    }
+    String token = authorization.substring(7);
+    token.trim();
+    return token;
+}
@@ -0,0 +1,51 @@
+#ifndef AUTH_TOKEN_H
+#define AUTH_TOKEN_H
+
+#include <Arduino.h>
+
+// Lifetime of an issued token
+#define AUTH_TOKEN_TTL_SECONDS (24 * 60 * 60)
+// Recently verified tokens that skip the HMAC on their next use
+#define AUTH_TOKEN_CACHE_SIZE 8
+// Longest username kept in the verification cache; longer ones are always re-verified
+#define AUTH_TOKEN_MAX_SUBJECT 32
+
+#define AUTH_TOKEN_SIGNATURE_SIZE 32
+
+// Signed bearer tokens: "<username>.<expiry>.<hex HMAC-SHA256>".
+// The expiry is in seconds of uptime and the key is drawn from the hardware
+// RNG on first use, so every token becomes invalid when the device reboots.
+class AuthToken {
+private:
+    struct Entry {
+        uint8_t signature[AUTH_TOKEN_SIGNATURE_SIZE];
+        char subject[AUTH_TOKEN_MAX_SUBJECT];
+        uint32_t expires;
+        uint32_t lastUsed;
+        bool used;
+    };
+
+    static uint8_t secret[AUTH_TOKEN_SIGNATURE_SIZE];
+    static bool hasSecret;
+    static Entry cache[AUTH_TOKEN_CACHE_SIZE];
+    static uint32_t useCounter;
+    static portMUX_TYPE lock;
+
+    static void ensureSecret();
+    static void sign(const char* payload, size_t length, uint8_t* signature);
+    static uint32_t now();
+
+    static bool cached(const String& subject, uint32_t expires, const uint8_t* signature);
+    static void remember(const String& subject, uint32_t expires, const uint8_t* signature);
+
+public:
+    static String issue(const String& subject, uint32_t ttlSeconds = AUTH_TOKEN_TTL_SECONDS);
+
+    // Checks signature and expiry; on success stores the username in subject
+    static bool verify(const String& token, String* subject = nullptr);
+
+    // Token from an "Authorization: Bearer ..." header value, or "" if absent
+    static String fromHeader(const String& authorization);
+};
+
+#endif
@@ -1,24 +1,17 @@
 #include "Controller.h"
 
 Response Controller::view(AsyncWebServerRequest* request, const String& template_name, const JsonDocument& data) {
-    // TODO: Implement proper view rendering
-    String html = "<html><head><title>" + template_name + "</title></head>";
-    html += "<body><h1>View: " + template_name + "</h1>";
-    
-    // Simple data rendering
-    if (!data.isNull()) {
-        html += "<pre>" + data.as<String>() + "</pre>";
-    }
-    
-    html += "</body></html>";
-    
-    return Response(request).html(html);
+    return Response(request).view(template_name, data);
 }
 
 Response Controller::json(AsyncWebServerRequest* request, const JsonDocument& data) {
     return Response(request).json(data);
 }
 
+Response Controller::jsonStream(AsyncWebServerRequest* request, JsonDocument&& data) {
+    return Response(request).jsonStream(std::move(data));
+}
+
 Response Controller::redirect(AsyncWebServerRequest* request, const String& url) {
     return Response(request).redirect(url);
 }
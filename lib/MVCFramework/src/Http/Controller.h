@@ -13,6 +13,7 @@ protected:
     // Helper methods for controllers
     Response view(AsyncWebServerRequest* request, const String& template_name, const JsonDocument& data = JsonDocument());
     Response json(AsyncWebServerRequest* request, const JsonDocument& data);
+    Response jsonStream(AsyncWebServerRequest* request, JsonDocument&& data);
     Response redirect(AsyncWebServerRequest* request, const String& url);
     Response back(AsyncWebServerRequest* request);
     
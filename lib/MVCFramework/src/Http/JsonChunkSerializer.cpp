@@ -0,0 +1,161 @@
+#include "JsonChunkSerializer.h"
+
+namespace {
+    // ArduinoJson writer that keeps only the bytes in [offset, offset + capacity)
+    class JsonSliceWriter {
+    private:
+        uint8_t* buffer;
+        size_t capacity;
+        size_t offset;
+        size_t position;
+        size_t written;
+
+    public:
+        JsonSliceWriter(uint8_t* buffer, size_t capacity, size_t offset)
+            : buffer(buffer), capacity(capacity), offset(offset), position(0), written(0) {}
+
+        size_t write(uint8_t c) {
+            if (position >= offset && written < capacity) {
+                buffer[written++] = c;
+            }
+            position++;
+            return 1;
+        }
+
+        size_t write(const uint8_t* data, size_t length) {
+            for (size_t i = 0; i < length; i++) {
+                write(data[i]);
+            }
+            return length;
+        }
+
+        size_t size() const { return written; }
+    };
+}
+
+JsonChunkSerializer::JsonChunkSerializer(std::shared_ptr<const JsonDocument> document)
+    : document(std::move(document)), started(false), literal(""), tokenLength(0), tokenOffset(0) {}
+
+void JsonChunkSerializer::setLiteral(const char* text) {
+    literal = text;
+    tokenLength = strlen(text);
+    tokenOffset = 0;
+}
+
+// Formats ,"key": with ArduinoJson's escaping rules, since the length
+// announced up front came from measureJson()
+void JsonChunkSerializer::setKey(JsonString key, bool comma) {
+    keyText = comma ? ",\"" : "\"";
+    const char* text = key.c_str();
+    for (size_t i = 0; i < key.size(); i++) {
+        char c = text[i];
+        switch (c) {
+            case '"':  keyText += "\\\""; break;
+            case '\\': keyText += "\\\\"; break;
+            case '\b': keyText += "\\b"; break;
+            case '\f': keyText += "\\f"; break;
+            case '\n': keyText += "\\n"; break;
+            case '\r': keyText += "\\r"; break;
+            case '\t': keyText += "\\t"; break;
+            case '\0': keyText += "\\u0000"; break;
+            default:   keyText += c; break;
+        }
+    }
+    keyText += "\":";
+    setLiteral(keyText.c_str());
+}
+
+void JsonChunkSerializer::openValue(JsonVariantConst next) {
+    if (next.is<JsonObjectConst>()) {
+        JsonObjectConst object = next.as<JsonObjectConst>();
+        Frame frame = {true, true, false, false};
+        frame.member = object.begin();
+        frame.memberEnd = object.end();
+        frames.push_back(frame);
+        setLiteral("{");
+    } else if (next.is<JsonArrayConst>()) {
+        JsonArrayConst array = next.as<JsonArrayConst>();
+        Frame frame = {false, true, false, false};
+        frame.element = array.begin();
+        frame.elementEnd = array.end();
+        frames.push_back(frame);
+        setLiteral("[");
+    } else {
+        literal = nullptr;
+        value = next;
+        tokenLength = measureJson(next);
+        tokenOffset = 0;
+    }
+}
+
+// Moves to the next token; false once the document is complete
+bool JsonChunkSerializer::advance() {
+    if (!started) {
+        started = true;
+        openValue(document->as<JsonVariantConst>());
+        return true;
+    }
+    if (frames.empty()) {
+        return false;
+    }
+
+    Frame& frame = frames.back();
+    if (frame.object) {
+        if (frame.valueDue) {
+            frame.valueDue = false;
+            JsonVariantConst next = (*frame.member).value();
+            ++frame.member;
+            openValue(next);
+            return true;
+        }
+        if (frame.member != frame.memberEnd) {
+            setKey((*frame.member).key(), !frame.first);
+            frame.first = false;
+            frame.valueDue = true;
+            return true;
+        }
+    } else if (frame.element != frame.elementEnd) {
+        if (!frame.first && !frame.commaDue) {
+            frame.commaDue = true;
+            setLiteral(",");
+            return true;
+        }
+        frame.first = false;
+        frame.commaDue = false;
+        JsonVariantConst next = *frame.element;
+        ++frame.element;
+        openValue(next);
+        return true;
+    }
+
+    bool object = frame.object;
+    frames.pop_back();
+    setLiteral(object ? "}" : "]");
+    return true;
+}
+
+size_t JsonChunkSerializer::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (tokenOffset >= tokenLength) {
+            if (!advance()) {
+                break;
+            }
+            continue;
+        }
+
+        size_t room = maxLen - written;
+        size_t produced;
+        if (literal) {
+            produced = tokenLength - tokenOffset < room ? tokenLength - tokenOffset : room;
+            memcpy(buffer + written, literal + tokenOffset, produced);
+        } else {
+            JsonSliceWriter writer(buffer + written, room, tokenOffset);
+            serializeJson(value, writer);
+            produced = writer.size();
+        }
+        tokenOffset += produced;
+        written += produced;
+    }
+    return written;
+}
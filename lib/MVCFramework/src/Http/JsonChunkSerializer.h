@@ -0,0 +1,54 @@
+#ifndef JSON_CHUNK_SERIALIZER_H
+#define JSON_CHUNK_SERIALIZER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <memory>
+#include <vector>
+
+// Serializes a document incrementally into whatever window the caller hands
+// read(), resuming where the previous call stopped. Containers are walked
+// with an explicit stack and only scalars go through serializeJson(), so a
+// call costs work in proportion to the bytes it returns rather than to the
+// document, and the serialized form never exists in memory as a whole.
+// The output is byte for byte what serializeJson() would produce, so
+// measureJson() gives its length.
+class JsonChunkSerializer {
+private:
+    struct Frame {
+        bool object;
+        bool first;
+        bool valueDue;       // object: key written, its value comes next
+        bool commaDue;       // array: separator written, element comes next
+        JsonObjectConst::iterator member;
+        JsonObjectConst::iterator memberEnd;
+        JsonArrayConst::iterator element;
+        JsonArrayConst::iterator elementEnd;
+    };
+
+    std::shared_ptr<const JsonDocument> document;
+    std::vector<Frame> frames;
+    bool started;
+
+    // Token being written and how much of it already went out. Literal
+    // tokens are punctuation or a formatted key; a scalar is re-sliced from
+    // serializeJson() only while it straddles a window boundary.
+    const char* literal;
+    String keyText;
+    JsonVariantConst value;
+    size_t tokenLength;
+    size_t tokenOffset;
+
+    void setLiteral(const char* text);
+    void setKey(JsonString key, bool comma);
+    void openValue(JsonVariantConst next);
+    bool advance();
+
+public:
+    explicit JsonChunkSerializer(std::shared_ptr<const JsonDocument> document);
+
+    // Fills up to maxLen bytes; returns 0 once the document is complete
+    size_t read(uint8_t* buffer, size_t maxLen);
+};
+
+#endif
@@ -0,0 +1,298 @@
+#include "LiveState.h"
+#include "WebSocketBroadcast.h"
+
+LiveState* LiveState::instance = nullptr;
+
+LiveState::LiveState()
+    : version(0), floor(0), tombstones(0), pushed(0), resyncPending(false), outbox(nullptr), lock(xSemaphoreCreateMutex()) {
+}
+
+LiveState* LiveState::getInstance() {
+    if (instance == nullptr) {
+        instance = new LiveState();
+    }
+    return instance;
+}
+
+// Callers hold the lock
+void LiveState::store(const String& collection, const String& id, const String& json) {
+    Collection& target = collections[collection];
+    auto it = target.items.find(id);
+
+    if (it != target.items.end() && !it->second.removed && it->second.json == json) {
+        return;
+    }
+
+    version++;
+    target.version = version;
+    if (it == target.items.end()) {
+        target.items[id] = {json, version, version, false};
+        return;
+    }
+
+    Item& item = it->second;
+    if (item.removed) {
+        // Back after a removal: to a client that saw the removal it is new
+        item.created = version;
+        item.removed = false;
+        tombstones--;
+    }
+    item.json = json;
+    item.updated = version;
+}
+
+// Callers hold the lock
+void LiveState::erase(const String& collection, const String& id) {
+    auto found = collections.find(collection);
+    if (found == collections.end()) {
+        return;
+    }
+    auto it = found->second.items.find(id);
+    if (it == found->second.items.end() || it->second.removed) {
+        return;
+    }
+
+    version++;
+    found->second.version = version;
+    it->second.removed = true;
+    it->second.updated = version;
+    it->second.json = String();
+    tombstones++;
+    pruneTombstones();
+}
+
+void LiveState::pruneTombstones() {
+    if (tombstones <= LIVE_STATE_MAX_TOMBSTONES) {
+        return;
+    }
+
+    // Forget every removal; clients that have not seen them need a snapshot
+    for (auto& collection : collections) {
+        auto& items = collection.second.items;
+        for (auto it = items.begin(); it != items.end();) {
+            if (it->second.removed) {
+                it = items.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    tombstones = 0;
+    floor = version;
+}
+
+void LiveState::set(const String& collection, const String& id, const JsonDocument& value) {
+    String json;
+    serializeJson(value, json);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    store(collection, id, json);
+    xSemaphoreGive(lock);
+}
+
+void LiveState::remove(const String& collection, const String& id) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    erase(collection, id);
+    xSemaphoreGive(lock);
+}
+
+void LiveState::replace(const String& collection, const JsonDocument& values) {
+    std::map<String, String> serializedValues;
+    for (JsonPairConst member : values.as<JsonObjectConst>()) {
+        String json;
+        serializeJson(member.value(), json);
+        serializedValues[member.key().c_str()] = json;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    std::vector<String> stale;
+    auto found = collections.find(collection);
+    if (found != collections.end()) {
+        for (const auto& item : found->second.items) {
+            if (!item.second.removed && serializedValues.find(item.first) == serializedValues.end()) {
+                stale.push_back(item.first);
+            }
+        }
+    }
+    for (const String& id : stale) {
+        erase(collection, id);
+    }
+    for (const auto& value : serializedValues) {
+        store(collection, value.first, value.second);
+    }
+    xSemaphoreGive(lock);
+}
+
+void LiveState::writeSnapshot(JsonDocument& out) {
+    out["type"] = "snapshot";
+    out["version"] = version;
+    JsonObject state = out["state"].to<JsonObject>();
+    for (const auto& collection : collections) {
+        JsonObject items = state[collection.first].to<JsonObject>();
+        for (const auto& item : collection.second.items) {
+            if (!item.second.removed) {
+                items[item.first] = serialized(item.second.json);
+            }
+        }
+    }
+}
+
+void LiveState::writePatch(JsonDocument& out, uint32_t since) {
+    out["type"] = "patch";
+    out["from"] = since;
+    out["version"] = version;
+    JsonArray ops = out["ops"].to<JsonArray>();
+    for (const auto& collection : collections) {
+        if (collection.second.version <= since) {
+            continue;
+        }
+        for (const auto& item : collection.second.items) {
+            const Item& entry = item.second;
+            if (entry.updated <= since || (entry.removed && entry.created > since)) {
+                continue; // unchanged, or added and removed again within the window
+            }
+
+            JsonObject op = ops.add<JsonObject>();
+            op["path"] = collection.first + "/" + item.first;
+            if (entry.removed) {
+                op["op"] = "remove";
+            } else {
+                op["op"] = entry.created > since ? "add" : "update";
+                op["value"] = serialized(entry.json);
+            }
+        }
+    }
+}
+
+// Callers hold the lock
+AsyncWebSocketSharedBuffer LiveState::render(uint32_t since) {
+    JsonDocument message;
+    if (needsSnapshot(since)) {
+        writeSnapshot(message);
+    } else {
+        writePatch(message, since);
+    }
+    return WebSocketBroadcast::makeBuffer(message);
+}
+
+void LiveState::commit() {
+    struct Message {
+        uint32_t clientId;
+        String key;
+        AsyncWebSocketSharedBuffer buffer;
+    };
+    std::vector<Message> messages;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (outbox && (version != pushed || resyncPending)) {
+        pushed = version;
+        resyncPending = false;
+
+        // Clients usually share an acknowledged version, so each distinct
+        // base is rendered once
+        std::map<uint32_t, AsyncWebSocketSharedBuffer> rendered;
+        for (auto& client : acked) {
+            uint32_t since = client.second;
+            if (since == version) {
+                continue;
+            }
+            AsyncWebSocketSharedBuffer& buffer = rendered[since];
+            if (!buffer) {
+                buffer = render(since);
+            }
+
+            // A newer patch from the same base covers the older one, so those
+            // coalesce; a snapshot is never replaced by a patch
+            if (needsSnapshot(since)) {
+                messages.push_back({client.first, LIVE_STATE_KEY_PREFIX "snapshot:" + String(version), buffer});
+                client.second = version; // patches may build on it, as in join()
+            } else {
+                messages.push_back({client.first, LIVE_STATE_KEY_PREFIX "patch:" + String(since), buffer});
+            }
+        }
+    }
+    WebSocketOutbox* target = outbox;
+    xSemaphoreGive(lock);
+
+    for (const Message& message : messages) {
+        target->send(message.clientId, message.key, message.buffer);
+    }
+}
+
+uint32_t LiveState::getVersion() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t value = version;
+    xSemaphoreGive(lock);
+    return value;
+}
+
+uint32_t LiveState::getVersion(const String& collection) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = collections.find(collection);
+    uint32_t value = it != collections.end() ? it->second.version : 0;
+    xSemaphoreGive(lock);
+    return value;
+}
+
+void LiveState::attach(WebSocketOutbox* socketOutbox) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    outbox = socketOutbox;
+    xSemaphoreGive(lock);
+
+    if (socketOutbox) {
+        socketOutbox->onDrop([this](uint32_t clientId, const String& key) {
+            if (key.startsWith(LIVE_STATE_KEY_PREFIX)) {
+                dropped(clientId);
+            }
+        });
+    }
+}
+
+// The client's chain of patches is broken; the next commit sends it a snapshot.
+// Runs with the outbox locked, which is fine since this lock is never held
+// while calling into the outbox.
+void LiveState::dropped(uint32_t clientId) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = acked.find(clientId);
+    if (it != acked.end()) {
+        it->second = NEEDS_SNAPSHOT;
+        resyncPending = true;
+    }
+    xSemaphoreGive(lock);
+}
+
+void LiveState::join(uint32_t clientId) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // The snapshot travels in order on the same connection, so patches may
+    // build on it before the client acknowledges it
+    acked[clientId] = version;
+    JsonDocument message;
+    writeSnapshot(message);
+    AsyncWebSocketSharedBuffer buffer = WebSocketBroadcast::makeBuffer(message);
+    String key = LIVE_STATE_KEY_PREFIX "snapshot:" + String(version);
+    WebSocketOutbox* target = outbox;
+    xSemaphoreGive(lock);
+
+    if (target) {
+        target->send(clientId, key, buffer);
+    }
+}
+
+void LiveState::acknowledge(uint32_t clientId, uint32_t clientVersion) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = acked.find(clientId);
+    if (it != acked.end() && clientVersion > it->second && clientVersion <= version) {
+        it->second = clientVersion;
+    }
+    xSemaphoreGive(lock);
+}
+
+void LiveState::resync(uint32_t clientId) {
+    join(clientId);
+}
+
+void LiveState::leave(uint32_t clientId) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    acked.erase(clientId);
+    xSemaphoreGive(lock);
+}
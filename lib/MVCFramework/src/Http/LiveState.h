@@ -0,0 +1,88 @@
+#ifndef LIVE_STATE_H
+#define LIVE_STATE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <map>
+#include <vector>
+#include "WebSocketOutbox.h"
+
+// Removed items remembered for patches; past this, clients further behind
+// than the removals get a snapshot instead
+#define LIVE_STATE_MAX_TOMBSTONES 64
+// Outbox keys: patches coalesce per base version, snapshots never replace
+// or get replaced by a patch
+#define LIVE_STATE_KEY_PREFIX "state."
+
+// Versioned model of what the dashboards display, kept as collections of
+// JSON values by id. Every change bumps a global version; subscribers get
+// a patch of the changes since the version they last acknowledged, and a
+// full snapshot only when they join or fall too far behind.
+//
+// Wire format, server to client:
+//   {"type":"snapshot","version":7,"state":{"<collection>":{"<id>":{...}}}}
+//   {"type":"patch","from":5,"version":7,"ops":[{"op":"add|update|remove","path":"<collection>/<id>","value":{...}}]}
+// Client to server: {"command":"ack","version":7} or {"command":"resync"}
+class LiveState {
+private:
+    struct Item {
+        String json;        // serialized value
+        uint32_t created;   // version that added it
+        uint32_t updated;   // version of its last change or removal
+        bool removed;
+    };
+
+    struct Collection {
+        std::map<String, Item> items;
+        uint32_t version = 0;
+    };
+
+    static LiveState* instance;
+    std::map<String, Collection> collections;
+    uint32_t version;
+    uint32_t floor;          // changes up to here may be missing from patches
+    size_t tombstones;
+    uint32_t pushed;         // version last sent to subscribers
+    bool resyncPending;      // a client lost a message and awaits a snapshot
+    WebSocketOutbox* outbox;
+    std::map<uint32_t, uint32_t> acked;   // client id -> version it holds
+    SemaphoreHandle_t lock;
+
+    // acked value of a client that missed a message; renders as a snapshot
+    static const uint32_t NEEDS_SNAPSHOT = UINT32_MAX;
+
+    LiveState();
+    void store(const String& collection, const String& id, const String& json);
+    void erase(const String& collection, const String& id);
+    void pruneTombstones();
+    void writeSnapshot(JsonDocument& out);
+    void writePatch(JsonDocument& out, uint32_t since);
+    AsyncWebSocketSharedBuffer render(uint32_t since);
+    bool needsSnapshot(uint32_t since) const { return since < floor || since > version; }
+    void dropped(uint32_t clientId);
+
+public:
+    static LiveState* getInstance();
+
+    // Changes are only recorded when the value differs from the stored one
+    void set(const String& collection, const String& id, const JsonDocument& value);
+    void remove(const String& collection, const String& id);
+    // Makes the collection hold exactly the members of values, an object keyed by id
+    void replace(const String& collection, const JsonDocument& values);
+
+    // Pushes pending changes to subscribers; call after a batch of updates
+    void commit();
+
+    uint32_t getVersion();
+    uint32_t getVersion(const String& collection);
+
+    // WebSocket side: attach once to the socket's outbox, then forward its events
+    void attach(WebSocketOutbox* socketOutbox);
+    void join(uint32_t clientId);
+    void acknowledge(uint32_t clientId, uint32_t clientVersion);
+    void resync(uint32_t clientId);
+    void leave(uint32_t clientId);
+};
+
+#endif
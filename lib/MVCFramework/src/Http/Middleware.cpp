@@ -1,13 +1,24 @@
 #include "Middleware.h"
 #include "Request.h"
 #include "Response.h"
+#include "AuthToken.h"
+#include "ResponseCache.h"
+#include "../Routing/Router.h"
+#include <SerialDebug.h>
+
+Response Next::operator()(Request& request) const {
+    if (index < route->pipeline.size()) {
+        return route->pipeline[index]->handle(request, Next(route, index + 1));
+    }
+    return route->handler(request);
+}
 
 // AuthMiddleware implementation
-Response AuthMiddleware::handle(Request& request, std::function<Response(Request&)> next) {
+Response AuthMiddleware::handle(Request& request, Next next) {
     // Check for authentication
-    String token = request.header("Authorization");
+    String token = AuthToken::fromHeader(request.header("Authorization"));
     
-    if (token.length() == 0 || !token.startsWith("Bearer ")) {
+    if (token.length() == 0) {
         // For web requests, redirect to login
         if (!request.wantsJson()) {
             return Response(request.getServerRequest())
@@ -24,11 +35,8 @@ Response AuthMiddleware::handle(Request& request, std::function<Response(Request
             .json(error);
     }
     
-    // Extract and validate token
-    String authToken = token.substring(7); // Remove "Bearer " prefix
-    
-    // Simple token validation - in production use proper JWT verification
-    if (!authToken.startsWith("cozmo_token_") || authToken.length() < 20) {
+    // Signature and expiry; recently seen tokens are answered from the verification cache
+    if (!AuthToken::verify(token)) {
         if (!request.wantsJson()) {
             return Response(request.getServerRequest())
                 .redirect("/login?redirect=" + request.path());
@@ -52,14 +60,14 @@ CorsMiddleware::CorsMiddleware(const String& origins, const String& methods, con
     : allowedOrigins(origins), allowedMethods(methods), allowedHeaders(headers) {
 }
 
-Response CorsMiddleware::handle(Request& request, std::function<Response(Request&)> next) {
+Response CorsMiddleware::handle(Request& request, Next next) {
     // Handle preflight requests
     if (request.method() == "OPTIONS") {
         return Response(request.getServerRequest())
-            .header("Access-Control-Allow-Origin", allowedOrigins)
-            .header("Access-Control-Allow-Methods", allowedMethods)
-            .header("Access-Control-Allow-Headers", allowedHeaders)
-            .header("Access-Control-Max-Age", "86400")
+            .header(HttpHeader::AccessControlAllowOrigin, allowedOrigins)
+            .header(HttpHeader::AccessControlAllowMethods, allowedMethods)
+            .header(HttpHeader::AccessControlAllowHeaders, allowedHeaders)
+            .header(HttpHeader::AccessControlMaxAge, "86400")
             .status(200)
             .content("");
     }
@@ -68,93 +76,139 @@ Response CorsMiddleware::handle(Request& request, std::function<Response(Request
     Response response = next(request);
     
     // Add CORS headers to response
-    response.header("Access-Control-Allow-Origin", allowedOrigins)
-           .header("Access-Control-Allow-Methods", allowedMethods)
-           .header("Access-Control-Allow-Headers", allowedHeaders);
+    response.header(HttpHeader::AccessControlAllowOrigin, allowedOrigins)
+           .header(HttpHeader::AccessControlAllowMethods, allowedMethods)
+           .header(HttpHeader::AccessControlAllowHeaders, allowedHeaders);
     
     return response;
 }
 
 // RateLimitMiddleware implementation
-RateLimitMiddleware::RateLimitMiddleware(int max, unsigned long window)
-    : maxRequests(max), windowMs(window) {
+RateLimitMiddleware::RateLimitMiddleware(int max, unsigned long window) : table(max, window) {
 }
 
-Response RateLimitMiddleware::handle(Request& request, std::function<Response(Request&)> next) {
-    String clientIp = request.ip();
-    unsigned long now = millis();
-    
-    // Cleanup old entries
-    cleanup();
-    
-    // Check current request count for this IP
-    auto it = requests.find(clientIp);
-    if (it != requests.end()) {
-        if (now - it->second.second < windowMs) {
-            if (it->second.first >= maxRequests) {
-                JsonDocument error;
-                error["error"] = "Too Many Requests";
-                error["message"] = "Rate limit exceeded";
-                error["retry_after"] = (windowMs - (now - it->second.second)) / 1000;
-                
-                return Response(request.getServerRequest())
-                    .status(429)
-                    .header("Retry-After", String((windowMs - (now - it->second.second)) / 1000))
-                    .json(error);
-            }
-            it->second.first++;
-        } else {
-            // Reset counter for new window
-            it->second.first = 1;
-            it->second.second = now;
-        }
-    } else {
-        // First request from this IP
-        requests[clientIp] = {1, now};
+std::shared_ptr<Middleware> RateLimitMiddleware::configure(const String& parameters) const {
+    int comma = parameters.indexOf(',');
+    int max = parameters.substring(0, comma).toInt();
+    long seconds = comma >= 0 ? parameters.substring(comma + 1).toInt() : table.getWindowMs() / 1000;
+    
+    if (max <= 0 || seconds <= 0) {
+        return nullptr;
+    }
+    return std::make_shared<RateLimitMiddleware>(max, seconds * 1000UL);
+}
+
+Response RateLimitMiddleware::handle(Request& request, Next next) {
+    uint32_t ip = request.remoteAddress();
+    uint32_t now = millis();
+    unsigned long retryAfterMs = 0;
+    
+    portENTER_CRITICAL(&lock);
+    bool allowed = table.take(ip, now, retryAfterMs);
+    portEXIT_CRITICAL(&lock);
+    
+    if (!allowed) {
+        unsigned long retryAfter = (retryAfterMs + 999) / 1000;
+        
+        JsonDocument error;
+        error["error"] = "Too Many Requests";
+        error["message"] = "Rate limit exceeded";
+        error["retry_after"] = retryAfter;
+        
+        return Response(request.getServerRequest())
+            .status(429)
+            .header(HttpHeader::RetryAfter, String(retryAfter))
+            .json(error);
     }
     
     return next(request);
 }
 
-void RateLimitMiddleware::cleanup() {
-    unsigned long now = millis();
-    auto it = requests.begin();
-    
-    while (it != requests.end()) {
-        if (now - it->second.second > windowMs) {
-            it = requests.erase(it);
-        } else {
-            ++it;
+// CacheMiddleware implementation
+CacheMiddleware::CacheMiddleware(uint32_t ttl, const String& tag) : ttlMs(ttl), tag(tag) {
+}
+
+std::shared_ptr<Middleware> CacheMiddleware::configure(const String& parameters) const {
+    int comma = parameters.indexOf(',');
+    long seconds = parameters.substring(0, comma).toInt();
+    String groupTag = comma >= 0 ? parameters.substring(comma + 1) : tag;
+    
+    if (seconds <= 0) {
+        return nullptr;
+    }
+    return std::make_shared<CacheMiddleware>(seconds * 1000UL, groupTag);
+}
+
+String CacheMiddleware::cacheKey(Request& request) {
+    String key = request.path();
+    String query = request.query();
+    if (query.length() > 0) {
+        key += '?';
+        key += query;
+    }
+    
+    if (request.hasHeader("Authorization")) {
+        key += '#';
+        key += request.header("Authorization");
+    }
+    return key;
+}
+
+Response CacheMiddleware::handle(Request& request, Next next) {
+    if (!request.isGet()) {
+        Response response = next(request);
+        if (response.getStatusCode() < 400) {
+            ResponseCache::getInstance()->invalidate(tag);
+        }
+        return response;
+    }
+    
+    ResponseCache* cache = ResponseCache::getInstance();
+    String key = cacheKey(request);
+    std::shared_ptr<const CachedResponse> entry = cache->get(key);
+    if (entry) {
+        return Response(request.getServerRequest()).cached(entry);
+    }
+    
+    // Taken first, so data read before a concurrent invalidate() is not stored after it
+    uint32_t generation = cache->generation(tag);
+    Response response = next(request);
+    if (response.getStatusCode() == 200) {
+        if (response.isBuffered()) {
+            cache->put(key, tag, generation, 200, response.getContentType(), response.getHeaders(), response.getContent(), ttlMs);
+        } else if (response.getJsonDocument()) {
+            cache->put(key, tag, generation, 200, response.getContentType(), response.getHeaders(), *response.getJsonDocument(), ttlMs);
         }
     }
+    return response;
 }
 
 // LoggingMiddleware implementation
-Response LoggingMiddleware::handle(Request& request, std::function<Response(Request&)> next) {
+Response LoggingMiddleware::handle(Request& request, Next next) {
     unsigned long startTime = millis();
     
     // Log request
-    Serial.printf("[%lu] %s %s from %s\n", 
-                  startTime, 
-                  request.method().c_str(), 
-                  request.path().c_str(), 
-                  request.ip().c_str());
+    LOG_INFO("[%lu] %s %s from %s",
+             startTime,
+             request.method().c_str(),
+             request.path().c_str(),
+             request.ip().c_str());
     
     // Continue to next middleware/handler
     Response response = next(request);
     
     // Log response
     unsigned long duration = millis() - startTime;
-    Serial.printf("[%lu] Response: %d in %lums\n", 
-                  millis(), 
-                  response.getStatusCode(), 
-                  duration);
+    LOG_INFO("[%lu] Response: %d in %lums",
+             millis(),
+             response.getStatusCode(),
+             duration);
     
     return response;
 }
 
 // JsonMiddleware implementation
-Response JsonMiddleware::handle(Request& request, std::function<Response(Request&)> next) {
+Response JsonMiddleware::handle(Request& request, Next next) {
     // Set default content type for API responses
     Response response = next(request);
     
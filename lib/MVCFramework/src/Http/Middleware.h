@@ -4,21 +4,40 @@
 #include <Arduino.h>
 #include <functional>
 #include <map>
+#include <memory>
+#include "RateLimitTable.h"
 
 // Forward declarations
 class Request;
 class Response;
+struct Route;
+
+// Continuation into the rest of a route's middleware pipeline. Pipelines are
+// resolved once by Router::init(), so calling next is an index bump.
+class Next {
+private:
+    const Route* route;
+    size_t index;
+
+public:
+    Next(const Route* route, size_t index) : route(route), index(index) {}
+    Response operator()(Request& request) const;
+};
 
 class Middleware {
 public:
     virtual ~Middleware() = default;
-    virtual Response handle(Request& request, std::function<Response(Request&)> next) = 0;
+    virtual Response handle(Request& request, Next next) = 0;
+    
+    // Instance configured from a "name:parameters" route reference, e.g.
+    // "ratelimit:20,60"; nullptr when the middleware takes no parameters
+    virtual std::shared_ptr<Middleware> configure(const String& parameters) const { return nullptr; }
 };
 
 // Auth middleware
 class AuthMiddleware : public Middleware {
 public:
-    Response handle(Request& request, std::function<Response(Request&)> next) override;
+    Response handle(Request& request, Next next) override;
 };
 
 // CORS middleware
@@ -33,34 +52,50 @@ public:
                    const String& methods = "GET,POST,PUT,DELETE,PATCH,OPTIONS",
                    const String& headers = "Content-Type,Authorization");
     
-    Response handle(Request& request, std::function<Response(Request&)> next) override;
+    Response handle(Request& request, Next next) override;
 };
 
-// Rate limiting middleware
+// Token-bucket rate limiting per IPv4 client, backed by a RateLimitTable.
+// Per route group: "ratelimit:<requests>,<seconds>", e.g. "ratelimit:20,60".
 class RateLimitMiddleware : public Middleware {
 private:
-    int maxRequests;
-    unsigned long windowMs;
-    std::map<String, std::pair<int, unsigned long>> requests;
+    RateLimitTable table;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
 
 public:
     RateLimitMiddleware(int max = 100, unsigned long window = 60000); // 100 requests per minute
-    Response handle(Request& request, std::function<Response(Request&)> next) override;
-    
+    Response handle(Request& request, Next next) override;
+    std::shared_ptr<Middleware> configure(const String& parameters) const override;
+};
+
+// Caches successful GET responses by path and query string in ResponseCache.
+// Per route group: "cache:<seconds>,<tag>", e.g. "cache:5,iot". Other
+// methods pass through and, when they succeed, invalidate the tag, as does
+// any producer calling ResponseCache::invalidate(tag). Requests carrying an
+// Authorization header are cached per token.
+class CacheMiddleware : public Middleware {
 private:
-    void cleanup();
+    uint32_t ttlMs;
+    String tag;
+
+    static String cacheKey(Request& request);
+
+public:
+    CacheMiddleware(uint32_t ttl = 5000, const String& tag = "");
+    Response handle(Request& request, Next next) override;
+    std::shared_ptr<Middleware> configure(const String& parameters) const override;
 };
 
 // Logging middleware
 class LoggingMiddleware : public Middleware {
 public:
-    Response handle(Request& request, std::function<Response(Request&)> next) override;
+    Response handle(Request& request, Next next) override;
 };
 
 // JSON middleware
 class JsonMiddleware : public Middleware {
 public:
-    Response handle(Request& request, std::function<Response(Request&)> next) override;
+    Response handle(Request& request, Next next) override;
 };
 
 #endif
@@ -0,0 +1,77 @@
+#include "RateLimitTable.h"
+
+static size_t homeSlot(uint32_t ip) {
+    return (ip * 2654435761u) & (RATE_LIMIT_TABLE_SIZE - 1);
+}
+
+RateLimitTable::RateLimitTable(int max, unsigned long window)
+    : maxRequests(max), windowMs(window), refillPerMs((float)max / window), sweepIndex(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+// Finds the client's bucket within its probe window. A new client takes a
+// free slot or evicts the least recently seen one; evicted clients simply
+// start again with a full bucket.
+RateLimitTable::Bucket& RateLimitTable::bucketFor(uint32_t ip, uint32_t now) {
+    size_t home = homeSlot(ip);
+    Bucket* victim = nullptr;
+    
+    for (size_t i = 0; i < RATE_LIMIT_PROBE_LENGTH; i++) {
+        Bucket& bucket = buckets[(home + i) & (RATE_LIMIT_TABLE_SIZE - 1)];
+        if (bucket.used && bucket.ip == ip) {
+            return bucket;
+        }
+        if (!victim || (!bucket.used && victim->used) ||
+            (bucket.used == victim->used && now - bucket.lastSeen > now - victim->lastSeen)) {
+            victim = &bucket;
+        }
+    }
+    
+    victim->ip = ip;
+    victim->lastSeen = now;
+    victim->tokens = maxRequests;
+    victim->used = true;
+    return *victim;
+}
+
+// Amortized expiry: each request frees a couple of slots idle for a whole
+// window, by which time their bucket would have been full again anyway
+void RateLimitTable::sweep(uint32_t now) {
+    for (int i = 0; i < 2; i++) {
+        Bucket& bucket = buckets[sweepIndex];
+        sweepIndex = (sweepIndex + 1) & (RATE_LIMIT_TABLE_SIZE - 1);
+        if (bucket.used && now - bucket.lastSeen >= windowMs) {
+            bucket.used = false;
+        }
+    }
+}
+
+bool RateLimitTable::take(uint32_t ip, uint32_t now, unsigned long& retryAfterMs) {
+    sweep(now);
+    
+    Bucket& bucket = bucketFor(ip, now);
+    bucket.tokens += (now - bucket.lastSeen) * refillPerMs;
+    if (bucket.tokens > maxRequests) {
+        bucket.tokens = maxRequests;
+    }
+    bucket.lastSeen = now;
+    
+    if (bucket.tokens >= 1.0f) {
+        bucket.tokens -= 1.0f;
+        retryAfterMs = 0;
+        return true;
+    }
+    retryAfterMs = (unsigned long)((1.0f - bucket.tokens) / refillPerMs);
+    return false;
+}
+
+bool RateLimitTable::tracks(uint32_t ip) const {
+    size_t home = homeSlot(ip);
+    for (size_t i = 0; i < RATE_LIMIT_PROBE_LENGTH; i++) {
+        const Bucket& bucket = buckets[(home + i) & (RATE_LIMIT_TABLE_SIZE - 1)];
+        if (bucket.used && bucket.ip == ip) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,47 @@
+#ifndef RATE_LIMIT_TABLE_H
+#define RATE_LIMIT_TABLE_H
+
+#include <Arduino.h>
+
+// Client slots per rate limiter (power of two)
+#define RATE_LIMIT_TABLE_SIZE 64
+// Slots searched per lookup; a full window evicts its least recently seen client
+#define RATE_LIMIT_PROBE_LENGTH 8
+
+// Token buckets per IPv4 client in a fixed open-addressed table, so a lookup
+// costs a bounded probe and no allocation. Not synchronized: the owner
+// serializes calls (RateLimitMiddleware holds a spinlock around take()).
+class RateLimitTable {
+private:
+    struct Bucket {
+        uint32_t ip;
+        uint32_t lastSeen;  // millis() of the last request, also the LRU stamp
+        float tokens;
+        bool used;
+    };
+    
+    int maxRequests;
+    unsigned long windowMs;
+    float refillPerMs;
+    
+    Bucket buckets[RATE_LIMIT_TABLE_SIZE];
+    size_t sweepIndex;
+    
+    Bucket& bucketFor(uint32_t ip, uint32_t now);
+    void sweep(uint32_t now);
+
+public:
+    RateLimitTable(int max, unsigned long window);
+    
+    // Spends one of ip's tokens at time now; when none is left returns false
+    // and sets retryAfterMs to the wait for the next one
+    bool take(uint32_t ip, uint32_t now, unsigned long& retryAfterMs);
+    
+    // True while ip holds a slot, i.e. has not been swept or evicted
+    bool tracks(uint32_t ip) const;
+    
+    int getMaxRequests() const { return maxRequests; }
+    unsigned long getWindowMs() const { return windowMs; }
+};
+
+#endif
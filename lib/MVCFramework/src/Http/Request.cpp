@@ -1,29 +1,81 @@
 #include "Request.h"
+#include <SerialDebug.h>
+#include <esp_heap_caps.h>
 
-// Static variable to store body data between handlers
-static String requestBodyData;
+static RequestBodyBuffer* allocateBodyBuffer(size_t capacity) {
+    size_t bytes = sizeof(RequestBodyBuffer) + capacity;
+    void* memory = nullptr;
+    
+    // Keep large bodies out of internal RAM
+    if (capacity >= REQUEST_BODY_PSRAM_THRESHOLD && psramFound()) {
+        memory = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!memory) {
+        memory = malloc(bytes);
+    }
+    if (!memory) {
+        return nullptr;
+    }
+    
+    RequestBodyBuffer* buffer = static_cast<RequestBodyBuffer*>(memory);
+    buffer->length = 0;
+    buffer->capacity = capacity;
+    buffer->data[0] = '\0';
+    return buffer;
+}
 
-// Body handler callback function
-void handleRequestBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-    if (total > 0 && data != nullptr) {
-        if (index == 0) {
-            requestBodyData = "";
+void Request::appendBodyChunk(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    if (data == nullptr || len == 0) {
+        return;
+    }
+    
+    RequestBodyBuffer* buffer = static_cast<RequestBodyBuffer*>(request->_tempObject);
+    
+    if (index == 0 && buffer == nullptr) {
+        size_t expected = total > len ? total : len;
+        if (expected > REQUEST_BODY_MAX_SIZE) {
+            LOG_WARNING("[Request] Body of %u bytes exceeds limit, dropping", (unsigned)expected);
+            return;
         }
         
-        for (size_t i = 0; i < len; i++) {
-            requestBodyData += (char)data[i];
+        // Content-Length is known up front, so this is normally the only allocation
+        buffer = allocateBodyBuffer(expected);
+        if (!buffer) {
+            LOG_ERROR("[Request] Unable to allocate %u byte body buffer", (unsigned)expected);
+            return;
         }
-        
-        if (index + len == total) {
-            // Store in request
-            request->_tempObject = new String(requestBodyData);
+        request->_tempObject = buffer;
+    }
+    
+    if (!buffer || index != buffer->length) {
+        return; // Body was dropped, or chunks arrived out of order
+    }
+    
+    if (buffer->length + len > buffer->capacity) {
+        // Sender under-declared its length; grow once to what is needed
+        size_t capacity = buffer->length + len;
+        if (capacity > REQUEST_BODY_MAX_SIZE) {
+            return;
+        }
+        RequestBodyBuffer* grown = allocateBodyBuffer(capacity);
+        if (!grown) {
+            return;
         }
+        memcpy(grown->data, buffer->data, buffer->length);
+        grown->length = buffer->length;
+        free(buffer);
+        buffer = grown;
+        request->_tempObject = buffer;
     }
+    
+    memcpy(buffer->data + buffer->length, data, len);
+    buffer->length += len;
+    buffer->data[buffer->length] = '\0';
 }
 
 // Static method to set up body handling for the server
 void Request::setupBodyHandling(AsyncWebServer* server) {
-    server->onRequestBody(handleRequestBody);
+    server->onRequestBody(Request::appendBodyChunk);
     
     // Set up file upload handling
     server->onFileUpload([](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
@@ -32,56 +84,101 @@ void Request::setupBodyHandling(AsyncWebServer* server) {
     });
 }
 
-Request::Request(AsyncWebServerRequest* request) : serverRequest(request) {
-    // Extract headers
-    int headerCount = request->headers();
-    for (int i = 0; i < headerCount; i++) {
-        const AsyncWebHeader* header = request->getHeader(i);
-        headers[header->name()] = header->value();
-    }
-    
-    // Extract parameters (but skip file uploads, as they're handled separately)
-    int paramCount = request->params();
-    for (int i = 0; i < paramCount; i++) {
-        const AsyncWebParameter* param = request->getParam(i);
-        if (!param->isFile()) {
-            parameters[param->name()] = param->value();
-            
-            // Check if this parameter is the request body (POST data)
-            if (param->isPost()) {
-                if (param->name() == "plain" || param->name() == "body" || param->name() == "") {
-                    body = param->value();
-                }
-            }
+Request::Request(AsyncWebServerRequest* request)
+    : serverRequest(request), rawBody(nullptr), routeParamNames(nullptr), routeParamCount(0) {
+    // Headers and parameters are read from the underlying request on demand.
+    // Raw body accumulated by the body handler is read in place rather than
+    // copied; the server frees it together with the request.
+    if (request && request->_tempObject != nullptr) {
+        rawBody = static_cast<const RequestBodyBuffer*>(request->_tempObject);
+    }
+}
+
+void Request::detach() {
+    if (snapshot || !serverRequest) return;
+    
+    std::shared_ptr<RequestSnapshot> copy = std::make_shared<RequestSnapshot>();
+    copy->method = serverRequest->method();
+    copy->url = serverRequest->url();
+    
+    size_t paramCount = serverRequest->params();
+    copy->params.reserve(paramCount);
+    for (size_t i = 0; i < paramCount; i++) {
+        const AsyncWebParameter* param = serverRequest->getParam(i);
+        if (param) {
+            copy->params.push_back({param->name(), param->value(), param->size(), param->isPost(), param->isFile()});
         }
     }
     
-    // Also try to get body from specific body parameters
-    const AsyncWebParameter* bodyParam = request->getParam("body", true);
-    if (!bodyParam) {
-        bodyParam = request->getParam("plain", true);
+    size_t headerCount = serverRequest->headers();
+    copy->headers.reserve(headerCount);
+    for (size_t i = 0; i < headerCount; i++) {
+        const AsyncWebHeader* header = serverRequest->getHeader(i);
+        if (header) {
+            copy->headers.push_back({header->name(), header->value(), 0, false, false});
+        }
     }
     
-    if (bodyParam && !bodyParam->isFile()) {
-        body = bodyParam->value();
+    if (rawBody) {
+        copy->body.reserve(rawBody->length);
+        copy->body.concat(rawBody->data, rawBody->length);
+        rawBody = nullptr; // freed with the server request
     }
     
-    // Check for raw body data stored by the body handler
-    if (body.isEmpty() && request->_tempObject != nullptr) {
-        // Get the body from the temporary object
-        String* tempBody = static_cast<String*>(request->_tempObject);
-        body = *tempBody;
-        
-        // Clean up (don't delete - the server will do this)
-        // delete tempBody;
-        // request->_tempObject = nullptr;
+    AsyncClient* client = serverRequest->client();
+    copy->remoteAddress = client ? client->getRemoteAddress() : 0;
+    
+    snapshot = copy;
+}
+
+const RequestSnapshot::Field* Request::findSnapshotParameter(const String& name, bool post, bool file) const {
+    for (const RequestSnapshot::Field& param : snapshot->params) {
+        if (param.post == post && param.file == file && param.name == name) {
+            return &param;
+        }
     }
+    return nullptr;
+}
+
+const String* Request::findParameter(const String& key) const {
+    // POST fields take precedence over query string values of the same name
+    if (snapshot) {
+        const RequestSnapshot::Field* param = findSnapshotParameter(key, true, false);
+        if (!param) {
+            param = findSnapshotParameter(key, false, false);
+        }
+        return param ? &param->value : nullptr;
+    }
+    if (!serverRequest) return nullptr;
+    
+    const AsyncWebParameter* param = serverRequest->getParam(key, true);
+    if (!param) {
+        param = serverRequest->getParam(key, false);
+    }
+    return (param && !param->isFile()) ? &param->value() : nullptr;
+}
+
+const String* Request::formBody() const {
+    if (snapshot) {
+        const RequestSnapshot::Field* param = findSnapshotParameter("body", true, false);
+        if (!param) {
+            param = findSnapshotParameter("plain", true, false);
+        }
+        return param ? &param->value : nullptr;
+    }
+    if (!serverRequest) return nullptr;
+    
+    const AsyncWebParameter* param = serverRequest->getParam("body", true);
+    if (!param) {
+        param = serverRequest->getParam("plain", true);
+    }
+    return (param && !param->isFile()) ? &param->value() : nullptr;
 }
 
 String Request::method() const {
-    if (!serverRequest) return "";
+    if (!snapshot && !serverRequest) return "";
     
-    switch (serverRequest->method()) {
+    switch (snapshot ? snapshot->method : serverRequest->method()) {
         case HTTP_GET: return "GET";
         case HTTP_POST: return "POST";
         case HTTP_PUT: return "PUT";
@@ -94,6 +191,7 @@ String Request::method() const {
 }
 
 String Request::url() const {
+    if (snapshot) return snapshot->url;
     if (!serverRequest) return "";
     return serverRequest->url();
 }
@@ -113,7 +211,27 @@ String Request::query() const {
     if (queryIndex >= 0) {
         return fullUrl.substring(queryIndex + 1);
     }
-    return "";
+    
+    // The server strips the query from url(), so rebuild it from the GET parameters
+    String rebuilt;
+    auto append = [&rebuilt](const String& name, const String& value) {
+        if (rebuilt.length() > 0) rebuilt += '&';
+        rebuilt += name;
+        rebuilt += '=';
+        rebuilt += value;
+    };
+    if (snapshot) {
+        for (const RequestSnapshot::Field& param : snapshot->params) {
+            if (!param.post && !param.file) append(param.name, param.value);
+        }
+    } else if (serverRequest) {
+        size_t count = serverRequest->params();
+        for (size_t i = 0; i < count; i++) {
+            const AsyncWebParameter* param = serverRequest->getParam(i);
+            if (param && !param->isPost() && !param->isFile()) append(param->name(), param->value());
+        }
+    }
+    return rebuilt;
 }
 
 String Request::input(const String& key, const String& defaultValue) const {
@@ -121,11 +239,22 @@ String Request::input(const String& key, const String& defaultValue) const {
 }
 
 String Request::get(const String& key, const String& defaultValue) const {
-    auto it = parameters.find(key);
-    if (it != parameters.end()) {
-        return it->second;
+    // Values set through setRouteParameter() win, so middleware can
+    // override what the path matched
+    if (!parameters.empty()) {
+        auto it = parameters.find(key);
+        if (it != parameters.end()) {
+            return it->second;
+        }
     }
-    return defaultValue;
+    
+    int routeIndex = findRouteParameter(key);
+    if (routeIndex >= 0) {
+        return routeParameterValue(routeIndex);
+    }
+    
+    const String* value = findParameter(key);
+    return value ? *value : defaultValue;
 }
 
 String Request::post(const String& key, const String& defaultValue) const {
@@ -136,22 +265,39 @@ String Request::post(const String& key, const String& defaultValue) const {
 }
 
 bool Request::has(const String& key) const {
-    return parameters.find(key) != parameters.end();
+    return findRouteParameter(key) >= 0 ||
+           parameters.find(key) != parameters.end() ||
+           findParameter(key) != nullptr;
 }
 
 String Request::header(const String& name, const String& defaultValue) const {
-    auto it = headers.find(name);
-    if (it != headers.end()) {
-        return it->second;
+    if (snapshot) {
+        // Header names are case-insensitive, as in AsyncWebServerRequest::getHeader()
+        for (const RequestSnapshot::Field& header : snapshot->headers) {
+            if (header.name.equalsIgnoreCase(name)) {
+                return header.value;
+            }
+        }
+        return defaultValue;
     }
-    return defaultValue;
+    const AsyncWebHeader* header = serverRequest ? serverRequest->getHeader(name) : nullptr;
+    return header ? header->value() : defaultValue;
 }
 
 bool Request::hasHeader(const String& name) const {
-    return headers.find(name) != headers.end();
+    if (snapshot) {
+        for (const RequestSnapshot::Field& header : snapshot->headers) {
+            if (header.name.equalsIgnoreCase(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    return serverRequest && serverRequest->hasHeader(name);
 }
 
 bool Request::hasFile(const String& name) const {
+    if (snapshot) return findSnapshotParameter(name, true, true) != nullptr;
     if (!serverRequest) return false;
     
     // Check if a file with this name exists in the request
@@ -159,6 +305,10 @@ bool Request::hasFile(const String& name) const {
 }
 
 String Request::getFile(const String& name) const {
+    if (snapshot) {
+        const RequestSnapshot::Field* param = findSnapshotParameter(name, true, true);
+        return param ? param->value : "";
+    }
     if (!serverRequest || !hasFile(name)) return "";
     
     const AsyncWebParameter* param = serverRequest->getParam(name, true, true);
@@ -169,6 +319,10 @@ String Request::getFile(const String& name) const {
 }
 
 String Request::getFileName(const String& name) const {
+    if (snapshot) {
+        const RequestSnapshot::Field* param = findSnapshotParameter(name, true, true);
+        return param ? param->name : "";
+    }
     if (!serverRequest || !hasFile(name)) return "";
     
     const AsyncWebParameter* param = serverRequest->getParam(name, true, true);
@@ -179,6 +333,10 @@ String Request::getFileName(const String& name) const {
 }
 
 size_t Request::getFileSize(const String& name) const {
+    if (snapshot) {
+        const RequestSnapshot::Field* param = findSnapshotParameter(name, true, true);
+        return param ? param->size : 0;
+    }
     if (!serverRequest || !hasFile(name)) return 0;
     
     const AsyncWebParameter* param = serverRequest->getParam(name, true, true);
@@ -193,15 +351,71 @@ bool Request::filled(const String& key) const {
     return value.length() > 0;
 }
 
+String Request::getBody() const {
+    if (body.length() > 0) {
+        return body;
+    }
+    
+    const String* form = formBody();
+    if (form) {
+        return *form;
+    }
+    
+    if (snapshot) {
+        return snapshot->body;
+    }
+    
+    if (!rawBody) {
+        return body;
+    }
+    
+    String content;
+    content.reserve(rawBody->length);
+    content.concat(rawBody->data, rawBody->length);
+    return content;
+}
+
+const char* Request::bodyData() const {
+    if (body.length() > 0) {
+        return body.c_str();
+    }
+    
+    const String* form = formBody();
+    if (form) {
+        return form->c_str();
+    }
+    
+    if (snapshot) {
+        return snapshot->body.c_str();
+    }
+    return rawBody ? rawBody->data : "";
+}
+
+size_t Request::bodyLength() const {
+    if (body.length() > 0) {
+        return body.length();
+    }
+    
+    const String* form = formBody();
+    if (form) {
+        return form->length();
+    }
+    
+    if (snapshot) {
+        return snapshot->body.length();
+    }
+    return rawBody ? rawBody->length : 0;
+}
+
 JsonDocument Request::json() const {
     JsonDocument doc;
-    if (body.length() > 0) {
-        DeserializationError error = deserializeJson(doc, body);
+    size_t length = bodyLength();
+    if (length > 0) {
+        // Parse straight from the body buffer without an intermediate String
+        const char* data = bodyData();
+        DeserializationError error = deserializeJson(doc, data, length);
         if (error) {
-            Serial.print("Failed to parse JSON body: ");
-            Serial.println(error.c_str());
-            Serial.print("Body content: ");
-            Serial.println(body);
+            LOG_WARNING("[Request] Failed to parse JSON body: %s (%u bytes)", error.c_str(), (unsigned)length);
         }
     }
     return doc;
@@ -216,14 +430,29 @@ bool Request::wantsJson() const {
 }
 
 String Request::ip() const {
+    if (snapshot) return IPAddress(snapshot->remoteAddress).toString();
     if (!serverRequest) return "";
     return serverRequest->client()->remoteIP().toString();
 }
 
+uint32_t Request::remoteAddress() const {
+    if (snapshot) return snapshot->remoteAddress;
+    if (!serverRequest || !serverRequest->client()) return 0;
+    return serverRequest->client()->getRemoteAddress();
+}
+
 String Request::userAgent() const {
     return header("User-Agent");
 }
 
+void Request::setRouteParameters(const std::vector<String>& names, const RouteMatch& match) {
+    routeParamNames = names.data();
+    routeParamCount = match.paramCount < names.size() ? match.paramCount : names.size();
+    for (uint8_t i = 0; i < routeParamCount; i++) {
+        routeParams[i] = match.params[i];
+    }
+}
+
 void Request::setRouteParameter(const String& key, const String& value) {
     parameters[key] = value;
 }
@@ -231,3 +460,19 @@ void Request::setRouteParameter(const String& key, const String& value) {
 String Request::route(const String& key, const String& defaultValue) const {
     return get(key, defaultValue);
 }
+
+int Request::findRouteParameter(const String& key) const {
+    for (uint8_t i = 0; i < routeParamCount; i++) {
+        if (routeParamNames[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+String Request::routeParameterValue(int index) const {
+    // Only materialize the value when a handler actually asks for it
+    const RouteParamSlice& slice = routeParams[index];
+    const String& source = snapshot ? snapshot->url : serverRequest->url();
+    return source.substring(slice.offset, slice.offset + slice.length);
+}
@@ -5,13 +5,61 @@
 #include <ArduinoJson.h>
 #include "ESPAsyncWebServer.h"
 #include <map>
+#include <memory>
+#include <vector>
+#include "../Routing/RouteTrie.h"
+
+// Largest body accumulated in memory; larger uploads need a streaming handler
+#define REQUEST_BODY_MAX_SIZE (256 * 1024)
+// Bodies at or above this size are placed in PSRAM when available
+#define REQUEST_BODY_PSRAM_THRESHOLD 4096
+
+// Raw body of one request, stored in AsyncWebServerRequest::_tempObject.
+// Allocated as a single block because the server releases _tempObject with free().
+struct RequestBodyBuffer {
+    size_t length;
+    size_t capacity;
+    char data[1]; // capacity + 1 bytes, NUL terminated
+};
+
+// Everything a handler can read from a request, copied on the AsyncTCP task.
+// Deferred handlers run on a worker and read this instead of the
+// AsyncWebServerRequest, which the server frees as soon as the client leaves.
+struct RequestSnapshot {
+    struct Field {
+        String name;
+        String value;
+        size_t size;
+        bool post;
+        bool file;
+    };
+    
+    WebRequestMethodComposite method;
+    String url;
+    std::vector<Field> params;
+    std::vector<Field> headers;
+    String body; // raw body collected by appendBodyChunk(), if any
+    uint32_t remoteAddress;
+};
 
 class Request {
 private:
     AsyncWebServerRequest* serverRequest;
-    std::map<String, String> parameters;
-    std::map<String, String> headers;
+    std::shared_ptr<const RequestSnapshot> snapshot; // set by detach()
+    std::map<String, String> parameters; // explicit overrides only, see setRouteParameter()
     String body;
+    const RequestBodyBuffer* rawBody;
+    
+    // Route parameters as slices of serverRequest->url(); names are owned by the Route
+    const String* routeParamNames;
+    RouteParamSlice routeParams[ROUTE_MAX_PARAMS];
+    uint8_t routeParamCount;
+    
+    const String* findParameter(const String& key) const;
+    const RequestSnapshot::Field* findSnapshotParameter(const String& name, bool post, bool file) const;
+    const String* formBody() const;
+    int findRouteParameter(const String& key) const;
+    String routeParameterValue(int index) const;
 
 public:
     Request(AsyncWebServerRequest* request);
@@ -19,6 +67,14 @@ public:
     // Static method to set up body handling
     static void setupBodyHandling(AsyncWebServer* server);
     
+    // Accumulate one body chunk into the request's own buffer
+    static void appendBodyChunk(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
+    
+    // Copy the request so it can be handled on another task. Call on the
+    // AsyncTCP task; afterwards nothing here reads the server request.
+    void detach();
+    bool isDetached() const { return snapshot != nullptr; }
+    
     // HTTP Methods
     String method() const;
     bool isGet() const { return method() == "GET"; }
@@ -43,8 +99,10 @@ public:
     bool hasHeader(const String& name) const;
     
     // Body
-    String getBody() const { return body; }
+    String getBody() const;
     void setBody(const String& content) { body = content; }
+    const char* bodyData() const;
+    size_t bodyLength() const;
     
     // Files
     bool hasFile(const String& name) const;
@@ -62,12 +120,16 @@ public:
     
     // Client info
     String ip() const;
+    uint32_t remoteAddress() const; // IPv4 in network byte order, 0 if unknown
     String userAgent() const;
     
     // Route parameters (set by router)
+    void setRouteParameters(const std::vector<String>& names, const RouteMatch& match);
     void setRouteParameter(const String& key, const String& value);
     String route(const String& key, const String& defaultValue = "") const;
     
+    // For building a Response. A detached request's handle must not be
+    // dereferenced: the server may already have freed it.
     AsyncWebServerRequest* getServerRequest() const { return serverRequest; }
 };
 
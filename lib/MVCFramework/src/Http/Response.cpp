@@ -1,111 +1,480 @@
 #include "Response.h"
+#include "ResponseCache.h"
+#include "JsonChunkSerializer.h"
+#include "../View/View.h"
+#include "../Routing/WorkerPool.h"
 #include <SPIFFS.h>
+#include <map>
+#include <set>
+#include <strings.h>
+
+// What flash holds for each served path: which variants exist, their size
+// and last write time, and a strong ETag per variant once hashed. Only the
+// first request for a path reads flash metadata; later ones read this table
+// and leave the background worker to re-stat the path at most every
+// RESPONSE_FILE_RECHECK_MS, dropping the ETag of a variant that changed.
+// Hashing reads the whole file, so it runs on the same worker; until it
+// finishes the variant is served without an ETag. Missing paths are not
+// cached, so requests for made-up names cannot grow the table.
+struct FileVariant {
+    bool exists;
+    size_t size;
+    time_t lastWrite;
+    String etag;
+};
+
+struct FileInfo {
+    FileVariant plain;
+    FileVariant gzip;
+    unsigned long checkedAt;
+    bool recheckPending;
+};
+
+static std::map<String, FileInfo> fileInfos;
+static std::set<String> pendingFileETags;
+static StaticSemaphore_t fileInfosMutexBuffer;
+static SemaphoreHandle_t fileInfosMutex = xSemaphoreCreateMutexStatic(&fileInfosMutexBuffer);
+static WorkerPool fileWorker;
+
+static FileVariant statFile(const String& spiffsPath) {
+    FileVariant variant = {false, 0, 0, String()};
+    File file = SPIFFS.open(spiffsPath, "r");
+    if (file) {
+        variant.exists = true;
+        variant.size = file.size();
+        variant.lastWrite = file.getLastWrite();
+        file.close();
+    }
+    return variant;
+}
+
+static bool sameContent(const FileVariant& a, const FileVariant& b) {
+    return a.exists == b.exists && a.size == b.size && a.lastWrite == b.lastWrite;
+}
+
+static void hashFileETag(const String& path, bool gzipped) {
+    String spiffsPath = gzipped ? path + ".gz" : path;
+    File file = SPIFFS.open(spiffsPath, "r");
+    if (file) {
+        size_t size = file.size();
+        time_t lastWrite = file.getLastWrite();
+        
+        // FNV-1a over the file content
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        uint8_t buffer[512];
+        size_t read;
+        while ((read = file.read(buffer, sizeof(buffer))) > 0) {
+            for (size_t i = 0; i < read; i++) {
+                hash ^= buffer[i];
+                hash *= 0x100000001b3ULL;
+            }
+        }
+        file.close();
+        
+        char value[40];
+        snprintf(value, sizeof(value), "\"%08x%08x-%x\"",
+                 (unsigned)(hash >> 32), (unsigned)(hash & 0xFFFFFFFF), (unsigned)size);
+        
+        // Kept only if the table still describes the content that was hashed
+        xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+        auto it = fileInfos.find(path);
+        if (it != fileInfos.end()) {
+            FileVariant& variant = gzipped ? it->second.gzip : it->second.plain;
+            if (variant.exists && variant.size == size && variant.lastWrite == lastWrite) {
+                variant.etag = value;
+            }
+        }
+        xSemaphoreGive(fileInfosMutex);
+    }
+    
+    xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+    pendingFileETags.erase(spiffsPath);
+    xSemaphoreGive(fileInfosMutex);
+}
+
+// Re-stats a cached path; a variant that changed loses its ETag, and a path
+// with no variant left is forgotten
+static void recheckFile(const String& path) {
+    FileVariant plain = statFile(path);
+    FileVariant gzip = statFile(path + ".gz");
+    
+    xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+    auto it = fileInfos.find(path);
+    if (it != fileInfos.end()) {
+        if (!plain.exists && !gzip.exists) {
+            fileInfos.erase(it);
+        } else {
+            FileInfo& info = it->second;
+            if (!sameContent(info.plain, plain)) info.plain = plain;
+            if (!sameContent(info.gzip, gzip)) info.gzip = gzip;
+            info.checkedAt = millis();
+            info.recheckPending = false;
+        }
+    }
+    xSemaphoreGive(fileInfosMutex);
+}
+
+// Which variants of path are on flash; false when neither is
+static bool lookupFile(const String& path, bool& hasPlain, bool& hasGzip) {
+    xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+    auto it = fileInfos.find(path);
+    if (it != fileInfos.end()) {
+        FileInfo& info = it->second;
+        hasPlain = info.plain.exists;
+        hasGzip = info.gzip.exists;
+        bool recheck = !info.recheckPending && millis() - info.checkedAt >= RESPONSE_FILE_RECHECK_MS;
+        info.recheckPending = info.recheckPending || recheck;
+        xSemaphoreGive(fileInfosMutex);
+        
+        if (recheck && !fileWorker.submit([path]() { recheckFile(path); })) {
+            // Worker not running or busy; check now rather than go stale
+            recheckFile(path);
+        }
+        return true;
+    }
+    xSemaphoreGive(fileInfosMutex);
+    
+    FileInfo info = {statFile(path), statFile(path + ".gz"), millis(), false};
+    hasPlain = info.plain.exists;
+    hasGzip = info.gzip.exists;
+    if (!hasPlain && !hasGzip) {
+        return false;
+    }
+    xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+    fileInfos.emplace(path, info);  // keeps an entry another task filled meanwhile
+    xSemaphoreGive(fileInfosMutex);
+    return true;
+}
+
+// Returns the cached ETag of one variant, or "" after scheduling its hash
+static String fileETag(const String& path, bool gzipped) {
+    String spiffsPath = gzipped ? path + ".gz" : path;
+    
+    xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+    auto it = fileInfos.find(path);
+    if (it == fileInfos.end()) {
+        xSemaphoreGive(fileInfosMutex);
+        return "";
+    }
+    const FileVariant& variant = gzipped ? it->second.gzip : it->second.plain;
+    if (variant.etag.length() > 0) {
+        String cached = variant.etag;
+        xSemaphoreGive(fileInfosMutex);
+        return cached;
+    }
+    bool schedule = variant.exists && pendingFileETags.insert(spiffsPath).second;
+    xSemaphoreGive(fileInfosMutex);
+    
+    if (schedule && !fileWorker.submit([path, gzipped]() { hashFileETag(path, gzipped); })) {
+        // Worker not running or busy; a later request tries again
+        xSemaphoreTake(fileInfosMutex, portMAX_DELAY);
+        pendingFileETags.erase(spiffsPath);
+        xSemaphoreGive(fileInfosMutex);
+    }
+    return "";
+}
+
+void Response::beginFileETags() {
+    fileWorker.begin(1, RESPONSE_ETAG_WORKER_CORE, RESPONSE_ETAG_WORKER_STACK, RESPONSE_ETAG_WORKER_PRIORITY, "FileETag");
+}
+
+// Fingerprinted names carry a content hash segment, e.g. app.3f9a2c1b.js,
+// so their content never changes under the same URL
+static bool isFingerprinted(const String& path) {
+    int start = path.lastIndexOf('/') + 1;
+    int segmentStart = path.indexOf('.', start);
+    
+    while (segmentStart >= 0) {
+        int segmentEnd = path.indexOf('.', segmentStart + 1);
+        if (segmentEnd < 0) break; // Last segment is the extension
+        
+        int length = segmentEnd - segmentStart - 1;
+        bool hex = length >= 8;
+        for (int i = segmentStart + 1; hex && i < segmentEnd; i++) {
+            hex = isxdigit((unsigned char)path.charAt(i));
+        }
+        if (hex) return true;
+        
+        segmentStart = segmentEnd;
+    }
+    return false;
+}
+
+namespace HttpHeader {
+    const char ContentType[] = "Content-Type";
+    const char ContentEncoding[] = "Content-Encoding";
+    const char ContentDisposition[] = "Content-Disposition";
+    const char ContentRange[] = "Content-Range";
+    const char AcceptRanges[] = "Accept-Ranges";
+    const char CacheControl[] = "Cache-Control";
+    const char ETag[] = "ETag";
+    const char Vary[] = "Vary";
+    const char Location[] = "Location";
+    const char RetryAfter[] = "Retry-After";
+    const char AccessControlAllowOrigin[] = "Access-Control-Allow-Origin";
+    const char AccessControlAllowMethods[] = "Access-Control-Allow-Methods";
+    const char AccessControlAllowHeaders[] = "Access-Control-Allow-Headers";
+    const char AccessControlMaxAge[] = "Access-Control-Max-Age";
+}
+
+static const char* const internedHeaderNames[] = {
+    HttpHeader::ContentType,
+    HttpHeader::ContentEncoding,
+    HttpHeader::ContentDisposition,
+    HttpHeader::ContentRange,
+    HttpHeader::AcceptRanges,
+    HttpHeader::CacheControl,
+    HttpHeader::ETag,
+    HttpHeader::Vary,
+    HttpHeader::Location,
+    HttpHeader::RetryAfter,
+    HttpHeader::AccessControlAllowOrigin,
+    HttpHeader::AccessControlAllowMethods,
+    HttpHeader::AccessControlAllowHeaders,
+    HttpHeader::AccessControlMaxAge,
+};
+
+static const char* internHeaderName(const char* name) {
+    for (const char* interned : internedHeaderNames) {
+        if (interned == name || strcasecmp(interned, name) == 0) {
+            return interned;
+        }
+    }
+    return nullptr;
+}
+
+// Idle body buffers. A buffer keeps its capacity while pooled, so steady-state
+// responses serialize into memory that is already allocated.
+static String* bodyPool[RESPONSE_BODY_POOL_SIZE];
+static size_t bodyPoolCount = 0;
+static portMUX_TYPE bodyPoolLock = portMUX_INITIALIZER_UNLOCKED;
+
+static void recycleBody(String* buffer) {
+    if (buffer->length() > RESPONSE_BODY_POOL_MAX_LENGTH) {
+        delete buffer;
+        return;
+    }
+    *buffer = ""; // Keeps the allocated capacity
+    
+    portENTER_CRITICAL(&bodyPoolLock);
+    if (bodyPoolCount < RESPONSE_BODY_POOL_SIZE) {
+        bodyPool[bodyPoolCount++] = buffer;
+        buffer = nullptr;
+    }
+    portEXIT_CRITICAL(&bodyPoolLock);
+    
+    delete buffer;
+}
+
+static std::shared_ptr<String> acquireBody() {
+    String* buffer = nullptr;
+    
+    portENTER_CRITICAL(&bodyPoolLock);
+    if (bodyPoolCount > 0) {
+        buffer = bodyPool[--bodyPoolCount];
+    }
+    portEXIT_CRITICAL(&bodyPoolLock);
+    
+    if (!buffer) {
+        buffer = new String();
+    }
+    return std::shared_ptr<String>(buffer, recycleBody);
+}
+
+static const String noContent;
 
 Response::Response(AsyncWebServerRequest* req) 
-    : request(req), statusCode(200), type("text/html"), 
-      binaryData(nullptr), binaryLength(0), isBinaryResponse(false) {
+    : request(req), type("text/html"), statusCode(200), headerCount(0),
+      binaryData(nullptr), binaryLength(0), isBinaryResponse(false),
+      fileHasGzip(false), fileHasPlain(false), fileGzipped(false), redirectBack(false) {
+}
+
+String& Response::writableBody() {
+    cachedBody.reset();
+    if (!body) {
+        body = acquireBody();
+    }
+    return *body;
+}
+
+void Response::clearBody() {
+    body.reset();
 }
 
-Response& Response::status(int code) {
+bool Response::isBuffered() const {
+    return !jsonDocument && !viewRenderer && !cachedBody && !isBinaryResponse && filePath.length() == 0;
+}
+
+Response& Response::cached(std::shared_ptr<const CachedResponse> entry) & {
+    clearBody();
+    cachedBody = entry;
+    statusCode = entry->statusCode;
+    type = entry->contentType;
+    for (const auto& stored : entry->headers) {
+        header(stored.first.c_str(), stored.second);
+    }
+    return *this;
+}
+
+std::vector<std::pair<String, String>> Response::getHeaders() const {
+    std::vector<std::pair<String, String>> result;
+    result.reserve(headerCount + extraHeaders.size());
+    for (uint8_t i = 0; i < headerCount; i++) {
+        result.emplace_back(headers[i].name(), headers[i].value);
+    }
+    for (const ResponseHeader& entry : extraHeaders) {
+        result.emplace_back(entry.name(), entry.value);
+    }
+    return result;
+}
+
+const String& Response::getContent() const {
+    return body ? *body : noContent;
+}
+
+Response& Response::status(int code) & {
     statusCode = code;
     return *this;
 }
 
-Response& Response::content(const String& body) {
-    this->body = body;
+Response& Response::content(const String& body) & {
+    writableBody() = body;
     isBinaryResponse = false;
     return *this;
 }
 
-Response& Response::html(const String& html) {
-    body = html;
+Response& Response::html(const String& html) & {
+    writableBody() = html;
     type = "text/html";
     isBinaryResponse = false;
     return *this;
 }
 
-Response& Response::text(const String& text) {
-    body = text;
+Response& Response::text(const String& text) & {
+    writableBody() = text;
     type = "text/plain";
     isBinaryResponse = false;
     return *this;
 }
 
-Response& Response::json(const JsonDocument& data) {
-    String jsonString;
-    serializeJson(data, jsonString);
-    body = jsonString;
+Response& Response::json(const JsonDocument& data) & {
+    // Serialize in place; the pooled buffer usually has the capacity already
+    String& buffer = writableBody();
+    buffer = "";
+    buffer.reserve(measureJson(data));
+    serializeJson(data, buffer);
     type = "application/json";
     isBinaryResponse = false;
     return *this;
 }
 
-Response& Response::json(const String& jsonString) {
-    body = jsonString;
+Response& Response::json(const String& jsonString) & {
+    writableBody() = jsonString;
     type = "application/json";
     isBinaryResponse = false;
     return *this;
 }
 
-Response& Response::binary(const uint8_t* data, size_t length, const String& contentType) {
+Response& Response::jsonStream(JsonDocument&& data) & {
+    // Keep only the document; it is serialized chunk by chunk while sending
+    jsonDocument = std::make_shared<JsonDocument>(std::move(data));
+    clearBody();
+    type = "application/json";
+    isBinaryResponse = false;
+    return *this;
+}
+
+Response& Response::binary(const uint8_t* data, size_t length, const String& contentType) & {
     binaryData = data;
     binaryLength = length;
     type = contentType;
     isBinaryResponse = true;
-    body = ""; // Clear text body for binary data
+    clearBody(); // Clear text body for binary data
     return *this;
 }
 
-Response& Response::header(const String& name, const String& value) {
-    headers[name] = value;
+ResponseHeader* Response::findHeader(const char* internedName, const char* name) {
+    for (uint8_t i = 0; i < headerCount; i++) {
+        ResponseHeader& entry = headers[i];
+        if (internedName ? entry.internedName == internedName : strcasecmp(entry.name(), name) == 0) {
+            return &entry;
+        }
+    }
+    for (ResponseHeader& entry : extraHeaders) {
+        if (internedName ? entry.internedName == internedName : strcasecmp(entry.name(), name) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+Response& Response::header(const char* name, const String& value) & {
+    const char* internedName = internHeaderName(name);
+    
+    ResponseHeader* entry = findHeader(internedName, name);
+    if (!entry) {
+        if (headerCount < RESPONSE_INLINE_HEADERS) {
+            entry = &headers[headerCount++];
+        } else {
+            extraHeaders.emplace_back();
+            entry = &extraHeaders.back();
+        }
+        entry->internedName = internedName;
+        if (!internedName) {
+            entry->customName = name;
+        }
+    }
+    entry->value = value;
     return *this;
 }
 
-Response& Response::contentType(const String& type) {
+Response& Response::contentType(const String& type) & {
     this->type = type;
     return *this;
 }
 
-Response& Response::redirect(const String& url, int code) {
+Response& Response::redirect(const String& url, int code) & {
     statusCode = code;
-    header("Location", url);
+    header(HttpHeader::Location, url);
     return *this;
 }
 
-Response& Response::back() {
-    // Get referer header and redirect there, or to home
-    String referer = "";
-    if (request->hasHeader("Referer")) {
-        referer = request->getHeader("Referer")->value();
-    }
-    if (referer.length() == 0) {
-        referer = "/";
-    }
-    return redirect(referer);
-}
-
-Response& Response::view(const String& template_name, const JsonDocument& data) {
-    // TODO: Implement view rendering
-    // For now, return simple HTML
-    body = "<html><body><h1>View: " + template_name + "</h1></body></html>";
-    type = "text/html";
+Response& Response::back() & {
+    // Redirect to the referer, or to home; resolved by send()
+    statusCode = 302;
+    redirectBack = true;
     return *this;
 }
 
-Response& Response::file(const String& path) {
-    // Check if file exists in SPIFFS
-    if (!SPIFFS.exists(path)) {
-        statusCode = 404;
-        body = "File not found";
+Response& Response::view(const String& template_name, const JsonDocument& data) & {
+    String error;
+    viewRenderer = TemplateEngine::getInstance()->renderer(template_name, data, error);
+    
+    if (!viewRenderer) {
+        statusCode = 500;
+        writableBody() = error;
         type = "text/plain";
         return *this;
     }
     
-    // Open file
-    File file = SPIFFS.open(path, "r");
-    if (!file) {
-        statusCode = 500;
-        body = "Unable to open file";
+    clearBody(); // The page is rendered by send()
+    type = "text/html";
+    isBinaryResponse = false;
+    return *this;
+}
+
+bool Response::acceptsGzip() const {
+    const AsyncWebHeader* acceptEncoding = request ? request->getHeader("Accept-Encoding") : nullptr;
+    return acceptEncoding && acceptEncoding->value().indexOf("gzip") >= 0;
+}
+
+Response& Response::file(const String& path) & {
+    // Prefer a precompressed sibling (built by scripts/compress_data.py)
+    bool hasPlain = false;
+    bool hasGzip = false;
+    if (!lookupFile(path, hasPlain, hasGzip)) {
+        statusCode = 404;
+        writableBody() = "File not found";
         type = "text/plain";
         return *this;
     }
@@ -140,19 +509,162 @@ Response& Response::file(const String& path) {
     }
     
     type = contentType;
+    clearBody(); // The file is streamed by send()
     
-    // For binary files, we need to handle them differently
-    // Store the file path for later use in send() method
-    body = ""; // Clear body for binary files
-    header("X-File-Path", path); // Store path in custom header for send() method
+    // The variant is negotiated by send(), which can read the request headers
+    filePath = path;
+    fileHasGzip = hasGzip;
+    fileHasPlain = hasPlain;
+    if (hasGzip && hasPlain) {
+        header(HttpHeader::Vary, "Accept-Encoding");
+    }
+    header(HttpHeader::CacheControl, isFingerprinted(path) ? "public, max-age=31536000, immutable" : "no-cache");
     
-    file.close();
     return *this;
 }
 
-Response& Response::download(const String& path, const String& name) {
+void Response::selectFileVariant() {
+    // Serve the compressed variant when the client accepts it, or when it is
+    // the only copy on flash. Range requests get the plain file so byte
+    // offsets stay stable regardless of the negotiated encoding; a gzip-only
+    // file is always sent whole, so only the plain variant advertises ranges.
+    bool rangeRequested = request->hasHeader("Range");
+    fileGzipped = fileHasGzip && (!fileHasPlain || (acceptsGzip() && !rangeRequested));
+    
+    // Validators so repeat loads can be answered with 304 Not Modified
+    etag = fileETag(filePath, fileGzipped);
+    
+    if (fileGzipped) {
+        filePath += ".gz";
+        header(HttpHeader::ContentEncoding, "gzip");
+    } else {
+        header(HttpHeader::AcceptRanges, "bytes");
+    }
+    if (etag.length() > 0) {
+        header(HttpHeader::ETag, etag);
+    }
+}
+
+// Parses one decimal position of a byte range; saturates instead of overflowing
+static bool parseRangePosition(const String& text, size_t& value) {
+    if (text.length() == 0) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        size_t digit = c - '0';
+        value = value > (SIZE_MAX - digit) / 10 ? SIZE_MAX : value * 10 + digit;
+    }
+    return true;
+}
+
+// Builds a 206 (or 416) response for a single "bytes=" range on filePath.
+// Returns nullptr when the full file should be sent instead: no Range
+// header, a multi-range or malformed range, or an If-Range that no longer
+// matches. 416 is reserved for a well-formed range that starts past the end.
+AsyncWebServerResponse* Response::beginRangeResponse() {
+    const AsyncWebHeader* rangeHeader = request->getHeader("Range");
+    if (!rangeHeader) {
+        return nullptr;
+    }
+    
+    const String& range = rangeHeader->value();
+    if (!range.startsWith("bytes=") || range.indexOf(',') >= 0) {
+        return nullptr;
+    }
+    
+    const AsyncWebHeader* ifRange = request->getHeader("If-Range");
+    if (ifRange && ifRange->value() != etag) {
+        return nullptr;
+    }
+    
+    // "start-end", "start-" or "-suffixLength"; anything else is ignored
+    int dash = range.indexOf('-');
+    if (dash < 0) {
+        return nullptr;
+    }
+    String first = range.substring(6, dash);
+    String last = range.substring(dash + 1);
+    first.trim();
+    last.trim();
+    
+    bool suffixRange = first.length() == 0;
+    size_t firstValue = 0;
+    size_t lastValue = 0;
+    bool hasLast = last.length() > 0;
+    if (suffixRange) {
+        if (!parseRangePosition(last, lastValue)) {
+            return nullptr;
+        }
+    } else {
+        if (!parseRangePosition(first, firstValue)) {
+            return nullptr;
+        }
+        if (hasLast && (!parseRangePosition(last, lastValue) || lastValue < firstValue)) {
+            return nullptr;
+        }
+    }
+    
+    std::shared_ptr<File> file = std::make_shared<File>(SPIFFS.open(filePath, "r"));
+    if (!*file) {
+        return nullptr;
+    }
+    size_t size = file->size();
+    
+    size_t start = firstValue;
+    size_t end = size > 0 ? size - 1 : 0;
+    if (suffixRange) {
+        // A zero-length suffix selects nothing and is unsatisfiable
+        start = lastValue == 0 ? size : (lastValue < size ? size - lastValue : 0);
+    } else if (hasLast && lastValue < end) {
+        end = lastValue;
+    }
+    
+    if (start >= size) {
+        file->close();
+        statusCode = 416;
+        AsyncWebServerResponse* response = request->beginResponse(416);
+        response->addHeader(HttpHeader::ContentRange, "bytes */" + String((unsigned)size));
+        return response;
+    }
+    
+    size_t length = end - start + 1;
+    AsyncWebServerResponse* response = request->beginResponse(type, length, [file, start, length](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+        if (index >= length) {
+            return 0;
+        }
+        size_t remaining = length - index;
+        if (maxLen > remaining) maxLen = remaining;
+        
+        if (file->position() != start + index) {
+            file->seek(start + index);
+        }
+        return file->read(buffer, maxLen);
+    });
+    
+    statusCode = 206;
+    response->setCode(206);
+    response->addHeader(HttpHeader::ContentRange, "bytes " + String((unsigned)start) + "-" + String((unsigned)end) + "/" + String((unsigned)size));
+    return response;
+}
+
+bool Response::etagMatches() const {
+    const AsyncWebHeader* ifNoneMatch = request ? request->getHeader("If-None-Match") : nullptr;
+    if (!ifNoneMatch || etag.length() == 0) {
+        return false;
+    }
+    
+    const String& candidates = ifNoneMatch->value();
+    return candidates == "*" || candidates.indexOf(etag) >= 0;
+}
+
+Response& Response::download(const String& path, const String& name) & {
     String filename = name.length() > 0 ? name : path;
-    header("Content-Disposition", "attachment; filename=\"" + filename + "\"");
+    header(HttpHeader::ContentDisposition, "attachment; filename=\"" + filename + "\"");
     return file(path);
 }
 
@@ -161,33 +673,102 @@ void Response::send() {
     
     AsyncWebServerResponse* response;
     
+    if (redirectBack) {
+        const AsyncWebHeader* referer = request->getHeader("Referer");
+        header(HttpHeader::Location, referer && referer->value().length() > 0 ? referer->value() : String("/"));
+    }
+    if (filePath.length() > 0) {
+        selectFileVariant();
+    }
+    
+    // Streamed JSON: the serialized form never exists in memory as a whole;
+    // each TCP chunk is produced from where the previous one stopped
+    if (jsonDocument) {
+        std::shared_ptr<JsonChunkSerializer> serializer = std::make_shared<JsonChunkSerializer>(jsonDocument);
+        response = request->beginResponse(type, measureJson(*jsonDocument), [serializer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return serializer->read(buffer, maxLen);
+        });
+        response->setCode(statusCode);
+    }
+    // Rendered view: streamed with chunked encoding as the renderer produces it
+    else if (viewRenderer) {
+        std::shared_ptr<TemplateRenderer> renderer = viewRenderer;
+        response = request->beginChunkedResponse(type, [renderer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            return renderer->read(buffer, maxLen);
+        });
+        response->setCode(statusCode);
+    }
+    // Cached body: the filler reads the cache's copy, which stays alive until sent
+    else if (cachedBody) {
+        std::shared_ptr<const CachedResponse> entry = cachedBody;
+        response = request->beginResponse(type, entry->length, [entry](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            if (index >= entry->length) {
+                return 0;
+            }
+            size_t chunk = entry->length - index < maxLen ? entry->length - index : maxLen;
+            memcpy(buffer, entry->body.get() + index, chunk);
+            return chunk;
+        });
+        response->setCode(statusCode);
+    }
     // Check if this is a binary response
-    if (isBinaryResponse && binaryData && binaryLength > 0) {
+    else if (isBinaryResponse && binaryData && binaryLength > 0) {
         // Send binary data
         response = request->beginResponse_P(statusCode, type, binaryData, binaryLength);
     }
+    // Client already has this exact file
+    else if (filePath.length() > 0 && etagMatches()) {
+        statusCode = 304;
+        response = request->beginResponse(304);
+    }
     // Check if this is a file response
-    else if (headers.find("X-File-Path") != headers.end()) {
-        String filePath = headers["X-File-Path"];
-        
-        // Remove the custom header before sending
-        headers.erase("X-File-Path");
+    else if (filePath.length() > 0) {
+        // Partial content for resumed downloads and media seeking
+        response = fileGzipped ? nullptr : beginRangeResponse();
         
-        // Serve file directly from SPIFFS
-        response = request->beginResponse(SPIFFS, filePath, type);
+        if (!response) {
+            // Serve file directly from SPIFFS; handing over the open file
+            // spares the server its own exists() probes
+            File file = SPIFFS.open(filePath, "r");
+            response = file ? request->beginResponse(file, filePath, type) : nullptr;
+        }
         
         if (!response) {
             // Fallback if file serving fails
             response = request->beginResponse(404, "text/plain", "File not found");
         }
+    } else if (body && body->length() > 0) {
+        // Text/json body: the filler reads from the pooled buffer, which goes
+        // back to the pool once the server has sent the last byte
+        std::shared_ptr<String> content = body;
+        response = request->beginResponse(type, content->length(), [content](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+            size_t length = content->length();
+            if (index >= length) {
+                return 0;
+            }
+            size_t chunk = length - index < maxLen ? length - index : maxLen;
+            memcpy(buffer, content->c_str() + index, chunk);
+            return chunk;
+        });
+        response->setCode(statusCode);
     } else {
-        // Regular text/json response
-        response = request->beginResponse(statusCode, type, body);
+        response = request->beginResponse(statusCode, type, String());
     }
     
-    // Add custom headers
-    for (const auto& pair : headers) {
-        response->addHeader(pair.first, pair.second);
+    // Add custom headers; a 304 or 416 carries none of the file, so it
+    // carries no Content-Encoding either
+    bool withoutFileBody = statusCode == 304 || statusCode == 416;
+    for (uint8_t i = 0; i < headerCount; i++) {
+        if (withoutFileBody && headers[i].internedName == HttpHeader::ContentEncoding) {
+            continue;
+        }
+        response->addHeader(headers[i].name(), headers[i].value);
+    }
+    for (const ResponseHeader& entry : extraHeaders) {
+        if (withoutFileBody && entry.internedName == HttpHeader::ContentEncoding) {
+            continue;
+        }
+        response->addHeader(entry.name(), entry.value);
     }
     
     request->send(response);
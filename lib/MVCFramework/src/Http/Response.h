@@ -2,65 +2,192 @@
 #define RESPONSE_H
 
 #include <Arduino.h>
-#include <map>
+#include <memory>
+#include <vector>
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 
+class TemplateRenderer;
+struct CachedResponse;
+
+// Headers stored inside the Response itself; further ones spill into a vector
+#define RESPONSE_INLINE_HEADERS 8
+// Number of idle body buffers kept for reuse
+#define RESPONSE_BODY_POOL_SIZE 4
+// Bodies longer than this release their buffer instead of returning it to the pool
+#define RESPONSE_BODY_POOL_MAX_LENGTH 4096
+// Background task that hashes SPIFFS files for their ETags and re-stats them
+#define RESPONSE_ETAG_WORKER_CORE 0
+#define RESPONSE_ETAG_WORKER_STACK 4096
+#define RESPONSE_ETAG_WORKER_PRIORITY 1
+// Minimum age of a served file's cached metadata before it is checked again
+#define RESPONSE_FILE_RECHECK_MS 2000
+
+// Interned header names. Response keeps a pointer to these instead of a
+// copy of the name; header() maps any matching name onto them.
+namespace HttpHeader {
+    extern const char ContentType[];
+    extern const char ContentEncoding[];
+    extern const char ContentDisposition[];
+    extern const char ContentRange[];
+    extern const char AcceptRanges[];
+    extern const char CacheControl[];
+    extern const char ETag[];
+    extern const char Vary[];
+    extern const char Location[];
+    extern const char RetryAfter[];
+    extern const char AccessControlAllowOrigin[];
+    extern const char AccessControlAllowMethods[];
+    extern const char AccessControlAllowHeaders[];
+    extern const char AccessControlMaxAge[];
+}
+
+struct ResponseHeader {
+    const char* internedName = nullptr; // one of the HttpHeader names, or nullptr
+    String customName;                  // only used when the name is not interned
+    String value;
+
+    const char* name() const { return internedName ? internedName : customName.c_str(); }
+};
+
+// Move-only: handlers and middleware hand the same Response down the chain.
+// The body lives in a pooled buffer shared with the send path, so neither
+// moving a Response nor sending it copies the body.
 class Response {
 private:
     AsyncWebServerRequest* request;
-    String body;
+    std::shared_ptr<String> body;
     String type;
     int statusCode;
-    std::map<String, String> headers;
-    
+
+    ResponseHeader headers[RESPONSE_INLINE_HEADERS];
+    uint8_t headerCount;
+    std::vector<ResponseHeader> extraHeaders;
+
     // Binary data support
     const uint8_t* binaryData;
     size_t binaryLength;
     bool isBinaryResponse;
 
+    // Document serialized straight into the TCP send path by send()
+    std::shared_ptr<JsonDocument> jsonDocument;
+    
+    // Views are rendered while sending, one TCP chunk at a time
+    std::shared_ptr<TemplateRenderer> viewRenderer;
+
+    // Body served straight from the response cache
+    std::shared_ptr<const CachedResponse> cachedBody;
+
+    // File responses: SPIFFS path actually served (may be a .gz sibling),
+    // chosen by send() from the variants found on flash
+    String filePath;
+    String etag;
+    bool fileHasGzip;
+    bool fileHasPlain;
+    bool fileGzipped;    // the .gz sibling was chosen; never served in byte ranges
+
+    // back(): Location is taken from the Referer header when sending
+    bool redirectBack;
+
+    String& writableBody();
+    void clearBody();
+    ResponseHeader* findHeader(const char* internedName, const char* name);
+
+    bool acceptsGzip() const;
+    void selectFileVariant();
+    bool etagMatches() const;
+    AsyncWebServerResponse* beginRangeResponse();
+
 public:
     Response(AsyncWebServerRequest* req);
-    
+
+    Response(Response&&) = default;
+    Response& operator=(Response&&) = default;
+    Response(const Response&) = delete;
+    Response& operator=(const Response&) = delete;
+
     // Status codes
-    Response& status(int code);
-    Response& ok() { return status(200); }
-    Response& created() { return status(201); }
-    Response& notFound() { return status(404); }
-    Response& unauthorized() { return status(401); }
-    Response& forbidden() { return status(403); }
-    Response& internalServerError() { return status(500); }
-    
+    Response& status(int code) &;
+    Response& ok() & { return status(200); }
+    Response& created() & { return status(201); }
+    Response& notFound() & { return status(404); }
+    Response& unauthorized() & { return status(401); }
+    Response& forbidden() & { return status(403); }
+    Response& internalServerError() & { return status(500); }
+
     // Content
-    Response& content(const String& body);
-    Response& html(const String& html);
-    Response& text(const String& text);
-    Response& json(const JsonDocument& data);
-    Response& json(const String& jsonString);
-    Response& binary(const uint8_t* data, size_t length, const String& contentType = "application/octet-stream");
-    
+    Response& content(const String& body) &;
+    Response& html(const String& html) &;
+    Response& text(const String& text) &;
+    Response& json(const JsonDocument& data) &;
+    Response& json(const String& jsonString) &;
+    Response& jsonStream(JsonDocument&& data) &;
+    Response& binary(const uint8_t* data, size_t length, const String& contentType = "application/octet-stream") &;
+
     // Headers
-    Response& header(const String& name, const String& value);
-    Response& contentType(const String& type);
-    
+    Response& header(const char* name, const String& value) &;
+    Response& header(const String& name, const String& value) & { return header(name.c_str(), value); }
+    Response& contentType(const String& type) &;
+
     // Redirects
-    Response& redirect(const String& url, int code = 302);
-    Response& back();
-    
+    Response& redirect(const String& url, int code = 302) &;
+    Response& back() &;
+
     // Views
-    Response& view(const String& template_name, const JsonDocument& data = JsonDocument());
-    
+    Response& view(const String& template_name, const JsonDocument& data = JsonDocument()) &;
+
+    // Replay a body held by ResponseCache without copying it
+    Response& cached(std::shared_ptr<const CachedResponse> entry) &;
+
     // File responses
-    Response& file(const String& path);
-    Response& download(const String& path, const String& name = "");
-    
-    // Send the response
+    Response& file(const String& path) &;
+    Response& download(const String& path, const String& name = "") &;
+
+    // Same builders on temporaries, so `return Response(req).status(404).json(doc);`
+    // moves the result out instead of copying it
+    Response&& status(int code) && { return std::move(status(code)); }
+    Response&& ok() && { return std::move(status(200)); }
+    Response&& created() && { return std::move(status(201)); }
+    Response&& notFound() && { return std::move(status(404)); }
+    Response&& unauthorized() && { return std::move(status(401)); }
+    Response&& forbidden() && { return std::move(status(403)); }
+    Response&& internalServerError() && { return std::move(status(500)); }
+    Response&& content(const String& body) && { return std::move(content(body)); }
+    Response&& html(const String& html) && { return std::move(this->html(html)); }
+    Response&& text(const String& text) && { return std::move(this->text(text)); }
+    Response&& json(const JsonDocument& data) && { return std::move(json(data)); }
+    Response&& json(const String& jsonString) && { return std::move(json(jsonString)); }
+    Response&& jsonStream(JsonDocument&& data) && { return std::move(jsonStream(std::move(data))); }
+    Response&& binary(const uint8_t* data, size_t length, const String& contentType = "application/octet-stream") && { return std::move(binary(data, length, contentType)); }
+    Response&& header(const char* name, const String& value) && { return std::move(header(name, value)); }
+    Response&& header(const String& name, const String& value) && { return std::move(header(name.c_str(), value)); }
+    Response&& contentType(const String& type) && { return std::move(contentType(type)); }
+    Response&& redirect(const String& url, int code = 302) && { return std::move(redirect(url, code)); }
+    Response&& back() && { return std::move(back()); }
+    Response&& view(const String& template_name, const JsonDocument& data = JsonDocument()) && { return std::move(view(template_name, data)); }
+    Response&& cached(std::shared_ptr<const CachedResponse> entry) && { return std::move(cached(entry)); }
+    Response&& file(const String& path) && { return std::move(file(path)); }
+    Response&& download(const String& path, const String& name = "") && { return std::move(download(path, name)); }
+
+    // Starts the task that computes file ETags and re-stats served files;
+    // until then files get no ETag and are rechecked on the request path
+    static void beginFileETags();
+
+    // Send the response. Reads the request's headers, so it must run on the
+    // AsyncTCP task; builders never touch the request and are safe anywhere.
     void send();
-    
+
     // Getters
     int getStatusCode() const { return statusCode; }
-    String getContent() const { return body; }
-    String getContentType() const { return type; }
+    const String& getContent() const;
+    const String& getContentType() const { return type; }
+    // True when the whole body sits in getContent(), i.e. not a file, view,
+    // stream or binary response
+    bool isBuffered() const;
+    // Headers set so far, by name and value
+    std::vector<std::pair<String, String>> getHeaders() const;
+    // Document of a jsonStream() response, nullptr otherwise
+    const JsonDocument* getJsonDocument() const { return jsonDocument.get(); }
 };
 
 #endif
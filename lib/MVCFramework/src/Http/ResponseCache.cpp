@@ -0,0 +1,164 @@
+#include "ResponseCache.h"
+#include <esp_heap_caps.h>
+
+ResponseCache* ResponseCache::instance = nullptr;
+
+ResponseCache::ResponseCache() : clearGeneration(0), bytes(0), hits(0), misses(0), lock(xSemaphoreCreateMutex()) {
+}
+
+ResponseCache* ResponseCache::getInstance() {
+    if (instance == nullptr) {
+        instance = new ResponseCache();
+    }
+    return instance;
+}
+
+std::shared_ptr<const CachedResponse> ResponseCache::get(const String& key) {
+    std::shared_ptr<const CachedResponse> result;
+    uint32_t now = millis();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        if ((int32_t)(now - it->second->expiresAt) >= 0) {
+            erase(it);
+        } else {
+            it->second->lastUsed = now;
+            result = it->second;
+        }
+    }
+    if (result) {
+        hits++;
+    } else {
+        misses++;
+    }
+    xSemaphoreGive(lock);
+
+    return result;
+}
+
+// Caller holds the lock
+uint32_t ResponseCache::currentGeneration(const String& tag) const {
+    auto it = generations.find(tag);
+    return clearGeneration + (it != generations.end() ? it->second : 0);
+}
+
+uint32_t ResponseCache::generation(const String& tag) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t value = currentGeneration(tag);
+    xSemaphoreGive(lock);
+    return value;
+}
+
+void ResponseCache::put(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+                        const CachedHeaders& headers, const String& body, uint32_t ttlMs) {
+    size_t length = body.length();
+    if (length == 0 || length > RESPONSE_CACHE_MAX_BODY) {
+        return;
+    }
+    uint8_t* data = allocate(length);
+    if (!data) {
+        return;
+    }
+    memcpy(data, body.c_str(), length);
+    store(key, tag, generation, statusCode, contentType, headers, data, length, ttlMs);
+}
+
+void ResponseCache::put(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+                        const CachedHeaders& headers, const JsonDocument& document, uint32_t ttlMs) {
+    size_t length = measureJson(document);
+    if (length == 0 || length > RESPONSE_CACHE_MAX_BODY) {
+        return;
+    }
+    // One spare byte for the terminator serializeJson() insists on writing
+    uint8_t* data = allocate(length + 1);
+    if (!data) {
+        return;
+    }
+    serializeJson(document, (char*)data, length + 1);
+    store(key, tag, generation, statusCode, contentType, headers, data, length, ttlMs);
+}
+
+uint8_t* ResponseCache::allocate(size_t length) {
+    uint8_t* data = nullptr;
+    if (psramFound()) {
+        data = (uint8_t*)heap_caps_malloc(length, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!data) {
+        data = (uint8_t*)malloc(length);
+    }
+    return data;
+}
+
+// Takes ownership of data, which must come from allocate()
+void ResponseCache::store(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+                          const CachedHeaders& headers, uint8_t* data, size_t length, uint32_t ttlMs) {
+    std::shared_ptr<CachedResponse> entry = std::make_shared<CachedResponse>();
+    entry->statusCode = statusCode;
+    entry->contentType = contentType;
+    entry->headers = headers;
+    entry->tag = tag;
+    entry->body = std::shared_ptr<const uint8_t>(data, [](const uint8_t* p) { free((void*)p); });
+    entry->length = length;
+    entry->lastUsed = millis();
+    entry->expiresAt = entry->lastUsed + ttlMs;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (currentGeneration(tag) != generation) {
+        // Invalidated while the response was being computed
+        xSemaphoreGive(lock);
+        return;
+    }
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        erase(it);
+    }
+    evict(length);
+    entries[key] = entry;
+    bytes += length;
+    xSemaphoreGive(lock);
+}
+
+void ResponseCache::invalidate(const String& tag) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (tag.length() == 0) {
+        clearGeneration++;
+    } else {
+        generations[tag]++;
+    }
+    for (auto it = entries.begin(); it != entries.end();) {
+        auto next = std::next(it);
+        if (tag.length() == 0 || it->second->tag == tag) {
+            erase(it);
+        }
+        it = next;
+    }
+    xSemaphoreGive(lock);
+}
+
+// Caller holds the lock. Expired entries go first, then least recently used.
+void ResponseCache::evict(size_t needed) {
+    uint32_t now = millis();
+    for (auto it = entries.begin(); it != entries.end();) {
+        auto next = std::next(it);
+        if ((int32_t)(now - it->second->expiresAt) >= 0) {
+            erase(it);
+        }
+        it = next;
+    }
+
+    while (!entries.empty() && bytes + needed > RESPONSE_CACHE_BUDGET) {
+        auto oldest = entries.begin();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if ((int32_t)(it->second->lastUsed - oldest->second->lastUsed) < 0) {
+                oldest = it;
+            }
+        }
+        erase(oldest);
+    }
+}
+
+void ResponseCache::erase(std::map<String, std::shared_ptr<CachedResponse>>::iterator it) {
+    bytes -= it->second->length;
+    entries.erase(it);
+}
@@ -0,0 +1,77 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Total body bytes the cache may hold
+#define RESPONSE_CACHE_BUDGET (64 * 1024)
+// Bodies larger than this are never cached
+#define RESPONSE_CACHE_MAX_BODY (16 * 1024)
+
+// Headers the handler set on a cached response, replayed on every hit
+typedef std::vector<std::pair<String, String>> CachedHeaders;
+
+// Serialized body, status and headers of one GET response. The body is kept in PSRAM
+// when available and shared with any response still sending it, so an
+// entry can be evicted or invalidated while it is on the wire.
+struct CachedResponse {
+    int statusCode;
+    String contentType;
+    CachedHeaders headers;
+    String tag;
+    std::shared_ptr<const uint8_t> body;
+    size_t length;
+    uint32_t expiresAt;  // millis()
+    uint32_t lastUsed;   // millis(), for LRU eviction
+};
+
+// Process-wide store behind CacheMiddleware. Producers that change what an
+// endpoint would return call invalidate() with the tag its routes use.
+class ResponseCache {
+private:
+    static ResponseCache* instance;
+    std::map<String, std::shared_ptr<CachedResponse>> entries;
+    std::map<String, uint32_t> generations; // per tag, bumped by invalidate()
+    uint32_t clearGeneration;               // bumped by invalidate("")
+    size_t bytes;
+    uint32_t hits;
+    uint32_t misses;
+    SemaphoreHandle_t lock;
+
+    ResponseCache();
+    uint8_t* allocate(size_t length);
+    uint32_t currentGeneration(const String& tag) const;
+    void store(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+               const CachedHeaders& headers, uint8_t* data, size_t length, uint32_t ttlMs);
+    void evict(size_t needed);
+    void erase(std::map<String, std::shared_ptr<CachedResponse>>::iterator it);
+
+public:
+    static ResponseCache* getInstance();
+
+    // Live entry for key, or nullptr when missing or expired
+    std::shared_ptr<const CachedResponse> get(const String& key);
+
+    // Taken before computing a response; put() refuses it if tag was
+    // invalidated since, as the response may predate the change
+    uint32_t generation(const String& tag);
+
+    void put(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+             const CachedHeaders& headers, const String& body, uint32_t ttlMs);
+    // Serializes a streamed JSON response once, so hits skip the serializer too
+    void put(const String& key, const String& tag, uint32_t generation, int statusCode, const String& contentType,
+             const CachedHeaders& headers, const JsonDocument& document, uint32_t ttlMs);
+
+    // Drop every entry stored under tag; an empty tag clears the whole cache
+    void invalidate(const String& tag);
+
+    size_t size() const { return bytes; }
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "WebSocketAssembler.h"
+#include <SerialDebug.h>
+#include <esp_heap_caps.h>
+
+WebSocketAssembler::~WebSocketAssembler() {
+    for (auto& entry : partials) {
+        release(entry.second);
+    }
+}
+
+bool WebSocketAssembler::reserve(Partial& partial, size_t needed) {
+    if (needed <= partial.capacity) {
+        return true;
+    }
+
+    // Frame lengths are known up front, so this normally allocates once per
+    // frame; doubling keeps long runs of small frames linear
+    size_t capacity = partial.capacity * 2 > needed ? partial.capacity * 2 : needed;
+    if (capacity > WS_MESSAGE_MAX_SIZE) {
+        capacity = WS_MESSAGE_MAX_SIZE;
+    }
+
+    uint8_t* grown = nullptr;
+    if (capacity >= WS_MESSAGE_PSRAM_THRESHOLD && psramFound()) {
+        grown = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!grown) {
+        grown = (uint8_t*)malloc(capacity);
+    }
+    if (!grown) {
+        return false;
+    }
+
+    if (partial.data) {
+        memcpy(grown, partial.data, partial.length);
+        free(partial.data);
+    }
+    partial.data = grown;
+    partial.capacity = capacity;
+    return true;
+}
+
+void WebSocketAssembler::release(Partial& partial) {
+    free(partial.data);
+    partial.data = nullptr;
+    partial.length = 0;
+    partial.capacity = 0;
+}
+
+void WebSocketAssembler::feed(uint32_t clientId, const AwsFrameInfo* info, uint8_t* data, size_t len, const MessageHandler& handler) {
+    bool frameEnd = info->index + len == info->len;
+    bool messageStart = info->num == 0 && info->index == 0;
+
+    if (messageStart && info->final && frameEnd) {
+        handler(info->opcode, data, len);
+        return;
+    }
+
+    auto it = partials.find(clientId);
+    if (messageStart) {
+        // A new message replaces whatever was left of an unfinished one
+        if (it == partials.end()) {
+            it = partials.emplace(clientId, Partial()).first;
+        }
+        it->second.length = 0;
+        it->second.opcode = info->opcode;
+        it->second.dropped = false;
+    } else if (it == partials.end()) {
+        return; // continuation of a message whose start was never seen
+    }
+
+    Partial& partial = it->second;
+    if (!partial.dropped) {
+        size_t needed = partial.length + (size_t)(info->len - info->index);
+        if (needed > WS_MESSAGE_MAX_SIZE || !reserve(partial, needed)) {
+            LOG_WARNING("[WebSocket] Dropping message from client %u: over %u bytes or out of memory",
+                        clientId, (unsigned)WS_MESSAGE_MAX_SIZE);
+            release(partial);
+            partial.dropped = true;
+        } else {
+            memcpy(partial.data + partial.length, data, len);
+            partial.length += len;
+        }
+    }
+
+    if (info->final && frameEnd) {
+        if (!partial.dropped) {
+            handler(partial.opcode, partial.data, partial.length);
+        }
+        release(partial);
+        partials.erase(it);
+    }
+}
+
+void WebSocketAssembler::remove(uint32_t clientId) {
+    auto it = partials.find(clientId);
+    if (it != partials.end()) {
+        release(it->second);
+        partials.erase(it);
+    }
+}
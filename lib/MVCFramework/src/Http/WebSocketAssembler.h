@@ -0,0 +1,43 @@
+#ifndef WEBSOCKET_ASSEMBLER_H
+#define WEBSOCKET_ASSEMBLER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <functional>
+#include <map>
+
+// Largest message a client may send; longer ones are discarded whole
+#define WS_MESSAGE_MAX_SIZE (64 * 1024)
+// Reassembly buffers from this size up are placed in PSRAM when available
+#define WS_MESSAGE_PSRAM_THRESHOLD 4096
+
+// Joins WebSocket messages that arrive as several frames, or as a frame
+// split over TCP segments, into one buffer per client. A message that
+// arrives in a single piece is passed through without copying.
+class WebSocketAssembler {
+public:
+    typedef std::function<void(uint8_t opcode, uint8_t* data, size_t length)> MessageHandler;
+
+private:
+    struct Partial {
+        uint8_t* data = nullptr;
+        size_t length = 0;
+        size_t capacity = 0;
+        uint8_t opcode = 0;
+        bool dropped = false;
+    };
+
+    std::map<uint32_t, Partial> partials;
+
+    bool reserve(Partial& partial, size_t needed);
+    void release(Partial& partial);
+
+public:
+    ~WebSocketAssembler();
+
+    // Feeds one WS_EVT_DATA event; calls handler once the message is complete
+    void feed(uint32_t clientId, const AwsFrameInfo* info, uint8_t* data, size_t len, const MessageHandler& handler);
+    void remove(uint32_t clientId);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "WebSocketBroadcast.h"
+
+uint32_t WebSocketBroadcast::sent = 0;
+uint32_t WebSocketBroadcast::skipped = 0;
+portMUX_TYPE WebSocketBroadcast::lock = portMUX_INITIALIZER_UNLOCKED;
+
+AsyncWebSocketSharedBuffer WebSocketBroadcast::makeBuffer(const JsonDocument& document) {
+    size_t length = measureJson(document);
+    // serializeJson() writes a terminator, which is then trimmed off the payload
+    AsyncWebSocketSharedBuffer buffer = std::make_shared<std::vector<uint8_t>>(length + 1);
+    serializeJson(document, (char*)buffer->data(), length + 1);
+    buffer->resize(length);
+    return buffer;
+}
+
+AsyncWebSocketSharedBuffer WebSocketBroadcast::makeBuffer(const String& text) {
+    return makeBuffer((const uint8_t*)text.c_str(), text.length());
+}
+
+AsyncWebSocketSharedBuffer WebSocketBroadcast::makeBuffer(const uint8_t* data, size_t length) {
+    return std::make_shared<std::vector<uint8_t>>(data, data + length);
+}
+
+size_t WebSocketBroadcast::send(AsyncWebSocket* ws, AsyncWebSocketSharedBuffer buffer, bool binary) {
+    if (!ws || !buffer) {
+        return 0;
+    }
+
+    size_t delivered = 0;
+    size_t full = 0;
+    for (AsyncWebSocketClient& client : ws->getClients()) {
+        if (client.status() != WS_CONNECTED) {
+            continue;
+        }
+        if (client.queueIsFull()) {
+            full++;
+            continue;
+        }
+        if (binary ? client.binary(buffer) : client.text(buffer)) {
+            delivered++;
+        } else {
+            full++;
+        }
+    }
+
+    portENTER_CRITICAL(&lock);
+    sent += delivered;
+    skipped += full;
+    portEXIT_CRITICAL(&lock);
+
+    return delivered;
+}
+
+void WebSocketBroadcast::prepare(AsyncWebSocketClient* client) {
+    if (client) {
+        // Overrides the library default, which disconnects a slow client
+        client->setCloseClientOnQueueFull(false);
+    }
+}
+
+uint32_t WebSocketBroadcast::getSent() {
+    portENTER_CRITICAL(&lock);
+    uint32_t value = sent;
+    portEXIT_CRITICAL(&lock);
+    return value;
+}
+
+uint32_t WebSocketBroadcast::getSkipped() {
+    portENTER_CRITICAL(&lock);
+    uint32_t value = skipped;
+    portEXIT_CRITICAL(&lock);
+    return value;
+}
@@ -0,0 +1,34 @@
+#ifndef WEBSOCKET_BROADCAST_H
+#define WEBSOCKET_BROADCAST_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+// Fan-out of one serialized message to every client of a socket. The payload
+// is built once into a refcounted buffer that each client's queue shares, so
+// a broadcast costs one serialization and no per-client copy. Clients whose
+// send queue is full are skipped rather than disconnected.
+class WebSocketBroadcast {
+private:
+    static uint32_t sent;
+    static uint32_t skipped;
+    static portMUX_TYPE lock;
+
+public:
+    static AsyncWebSocketSharedBuffer makeBuffer(const JsonDocument& document);
+    static AsyncWebSocketSharedBuffer makeBuffer(const String& text);
+    static AsyncWebSocketSharedBuffer makeBuffer(const uint8_t* data, size_t length);
+
+    // Queues buffer on every connected client; returns how many took it
+    static size_t send(AsyncWebSocket* ws, AsyncWebSocketSharedBuffer buffer, bool binary = false);
+
+    // Called for each new client. The library closes a client whose queue
+    // is full; after this the message is dropped and the client stays open
+    static void prepare(AsyncWebSocketClient* client);
+
+    static uint32_t getSent();
+    static uint32_t getSkipped();
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "WebSocketHub.h"
+#include "WebSocketBroadcast.h"
+
+WebSocketHub* WebSocketHub::instance = nullptr;
+
+WebSocketHub::WebSocketHub() : lock(xSemaphoreCreateMutex()) {
+}
+
+WebSocketHub* WebSocketHub::getInstance() {
+    if (instance == nullptr) {
+        instance = new WebSocketHub();
+    }
+    return instance;
+}
+
+void WebSocketHub::attach(AsyncWebSocket* ws, WebSocketOutbox* outbox) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    sockets[ws] = outbox;
+    xSemaphoreGive(lock);
+}
+
+uint32_t WebSocketHub::topicMask(const String& topic, bool create) {
+    uint32_t mask = 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t i = 0; i < topics.size(); i++) {
+        if (topics[i] == topic) {
+            mask = 1UL << i;
+            break;
+        }
+    }
+    if (mask == 0 && create && topic.length() > 0 && topics.size() < WS_HUB_MAX_TOPICS) {
+        topics.push_back(topic);
+        mask = 1UL << (topics.size() - 1);
+    }
+    xSemaphoreGive(lock);
+
+    return mask;
+}
+
+WebSocketOutbox* WebSocketHub::outboxFor(AsyncWebSocket* ws) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = sockets.find(ws);
+    WebSocketOutbox* outbox = it != sockets.end() ? it->second : nullptr;
+    xSemaphoreGive(lock);
+    return outbox;
+}
+
+std::vector<WebSocketOutbox*> WebSocketHub::subscribedOutboxes(uint32_t mask) {
+    std::vector<WebSocketOutbox*> result;
+    if (mask == 0) {
+        return result;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    std::vector<WebSocketOutbox*> all;
+    all.reserve(sockets.size());
+    for (const auto& entry : sockets) {
+        all.push_back(entry.second);
+    }
+    xSemaphoreGive(lock);
+
+    // Outboxes take their own lock, so they are asked outside the hub's
+    for (WebSocketOutbox* outbox : all) {
+        if (outbox->hasSubscribers(mask)) {
+            result.push_back(outbox);
+        }
+    }
+    return result;
+}
+
+bool WebSocketHub::registerTopic(const String& topic) {
+    return topicMask(topic, true) != 0;
+}
+
+bool WebSocketHub::subscribe(AsyncWebSocket* ws, uint32_t clientId, const String& topic) {
+    WebSocketOutbox* outbox = outboxFor(ws);
+    uint32_t mask = topicMask(topic, false);
+    if (!outbox || mask == 0) {
+        return false;
+    }
+    outbox->subscribe(clientId, mask);
+    return true;
+}
+
+void WebSocketHub::unsubscribe(AsyncWebSocket* ws, uint32_t clientId, const String& topic) {
+    WebSocketOutbox* outbox = outboxFor(ws);
+    uint32_t mask = topicMask(topic, false);
+    if (outbox && mask != 0) {
+        outbox->unsubscribe(clientId, mask);
+    }
+}
+
+bool WebSocketHub::hasSubscribers(const String& topic) {
+    return !subscribedOutboxes(topicMask(topic, false)).empty();
+}
+
+size_t WebSocketHub::publish(const String& topic, const JsonDocument& document, const String& key) {
+    uint32_t mask = topicMask(topic, false);
+    std::vector<WebSocketOutbox*> targets = subscribedOutboxes(mask);
+    if (targets.empty()) {
+        return 0;
+    }
+
+    AsyncWebSocketSharedBuffer buffer = WebSocketBroadcast::makeBuffer(document);
+    size_t delivered = 0;
+    for (WebSocketOutbox* outbox : targets) {
+        delivered += outbox->publish(key.length() > 0 ? key : topic, buffer, false, mask);
+    }
+    return delivered;
+}
+
+size_t WebSocketHub::publish(const String& topic, AsyncWebSocketSharedBuffer buffer, bool binary, const String& key) {
+    uint32_t mask = topicMask(topic, false);
+    size_t delivered = 0;
+    for (WebSocketOutbox* outbox : subscribedOutboxes(mask)) {
+        delivered += outbox->publish(key.length() > 0 ? key : topic, buffer, binary, mask);
+    }
+    return delivered;
+}
+
+std::vector<String> WebSocketHub::getTopics() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    std::vector<String> result = topics;
+    xSemaphoreGive(lock);
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef WEBSOCKET_HUB_H
+#define WEBSOCKET_HUB_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <map>
+#include <vector>
+#include "WebSocketOutbox.h"
+
+// Topics are bits in each client's subscription mask
+#define WS_HUB_MAX_TOPICS 32
+
+// Topic-based publish/subscribe over every WebSocket route. Producers
+// publish to a topic without knowing about clients; the payload is
+// serialized once and only queued for clients subscribed to that topic.
+// Topics are registered by the application at startup; clients can only
+// subscribe to those, so they cannot use up the topic table.
+class WebSocketHub {
+private:
+    static WebSocketHub* instance;
+    std::vector<String> topics;   // index is the topic's bit
+    std::map<AsyncWebSocket*, WebSocketOutbox*> sockets;
+    SemaphoreHandle_t lock;
+
+    WebSocketHub();
+    uint32_t topicMask(const String& topic, bool create);
+    WebSocketOutbox* outboxFor(AsyncWebSocket* ws);
+    std::vector<WebSocketOutbox*> subscribedOutboxes(uint32_t mask);
+
+public:
+    static WebSocketHub* getInstance();
+
+    // Called by the router for each WebSocket route it creates
+    void attach(AsyncWebSocket* ws, WebSocketOutbox* outbox);
+
+    // False when the topic table is full
+    bool registerTopic(const String& topic);
+
+    // False when the topic was never registered or the socket is unknown
+    bool subscribe(AsyncWebSocket* ws, uint32_t clientId, const String& topic);
+    void unsubscribe(AsyncWebSocket* ws, uint32_t clientId, const String& topic);
+
+    // Lets producers skip building a payload nobody will receive
+    bool hasSubscribers(const String& topic);
+
+    // Returns how many clients received the message immediately; the rest
+    // have it queued. Waiting messages with the same key replace each other,
+    // the key defaulting to the topic.
+    size_t publish(const String& topic, const JsonDocument& document, const String& key = "");
+    size_t publish(const String& topic, AsyncWebSocketSharedBuffer buffer, bool binary = false, const String& key = "");
+
+    std::vector<String> getTopics();
+};
+
+#endif
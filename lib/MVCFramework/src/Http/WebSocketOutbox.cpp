@@ -0,0 +1,236 @@
+#include "WebSocketOutbox.h"
+
+WebSocketOutbox::WebSocketOutbox(AsyncWebSocket* ws)
+    : ws(ws), dropped(0), coalesced(0), lock(xSemaphoreCreateMutex()) {
+    flushTimer = xTimerCreate("WsOutbox", pdMS_TO_TICKS(WS_OUTBOX_FLUSH_MS), pdTRUE, this, onFlushTimer);
+}
+
+void WebSocketOutbox::onFlushTimer(TimerHandle_t timer) {
+    static_cast<WebSocketOutbox*>(pvTimerGetTimerID(timer))->flush();
+}
+
+size_t WebSocketOutbox::publish(const String& key, AsyncWebSocketSharedBuffer buffer, bool binary, uint32_t mask) {
+    if (!ws || !buffer) {
+        return 0;
+    }
+
+    size_t delivered = 0;
+    bool queued = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto& entry : clients) {
+        ClientQueue& queue = entry.second;
+        AsyncWebSocketClient* client = queue.client;
+        if (!client || client->status() != WS_CONNECTED) {
+            continue;
+        }
+        if (mask != 0 && (queue.topics & mask) == 0) {
+            continue;
+        }
+
+        // Anything already waiting goes first, so order per client is kept
+        if (queue.pending.empty() && !client->queueIsFull()) {
+            if (binary ? client->binary(buffer) : client->text(buffer)) {
+                delivered++;
+                continue;
+            }
+        }
+
+        enqueue(entry.first, queue, key, buffer, binary);
+        queued = queued || !queue.pending.empty();
+    }
+    xSemaphoreGive(lock);
+
+    if (queued && flushTimer && xTimerIsTimerActive(flushTimer) == pdFALSE) {
+        xTimerStart(flushTimer, 0);
+    }
+    return delivered;
+}
+
+bool WebSocketOutbox::send(uint32_t clientId, const String& key, AsyncWebSocketSharedBuffer buffer, bool binary) {
+    if (!ws || !buffer) {
+        return false;
+    }
+
+    bool delivered = false;
+    bool queued = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = clients.find(clientId);
+    AsyncWebSocketClient* client = it != clients.end() ? it->second.client : nullptr;
+    if (client && client->status() == WS_CONNECTED) {
+        ClientQueue& queue = it->second;
+        if (queue.pending.empty() && !client->queueIsFull()) {
+            delivered = binary ? client->binary(buffer) : client->text(buffer);
+        }
+        if (!delivered) {
+            enqueue(clientId, queue, key, buffer, binary);
+            queued = !queue.pending.empty();
+        }
+    }
+    xSemaphoreGive(lock);
+
+    if (queued && flushTimer && xTimerIsTimerActive(flushTimer) == pdFALSE) {
+        xTimerStart(flushTimer, 0);
+    }
+    return delivered;
+}
+
+void WebSocketOutbox::shed(uint32_t clientId, ClientQueue& queue, const String& key) {
+    queue.dropped++;
+    dropped++;
+    if (dropHandler) {
+        dropHandler(clientId, key);
+    }
+}
+
+void WebSocketOutbox::enqueue(uint32_t clientId, ClientQueue& queue, const String& key, AsyncWebSocketSharedBuffer buffer, bool binary) {
+    size_t length = buffer->size();
+    bool replaced = false;
+
+    if (key.length() > 0) {
+        for (Pending& pending : queue.pending) {
+            if (pending.key == key) {
+                // Latest value wins; the message keeps its place in line
+                queue.bytes = queue.bytes - pending.buffer->size() + length;
+                pending.buffer = buffer;
+                pending.binary = binary;
+                queue.coalesced++;
+                coalesced++;
+                replaced = true;
+                break;
+            }
+        }
+    }
+
+    if (!replaced && length > WS_OUTBOX_BUDGET) {
+        shed(clientId, queue, key);
+        return;
+    }
+
+    // Over budget: shed the oldest messages, they are the most stale. A
+    // replacement may have grown the queue too, so it is checked the same way.
+    size_t incoming = replaced ? 0 : length;
+    while (queue.bytes + incoming > WS_OUTBOX_BUDGET && !queue.pending.empty()) {
+        Pending oldest = queue.pending.front();
+        queue.bytes -= oldest.buffer->size();
+        queue.pending.pop_front();
+        shed(clientId, queue, oldest.key);
+    }
+
+    if (!replaced) {
+        queue.pending.push_back({key, buffer, binary});
+        queue.bytes += length;
+    }
+}
+
+void WebSocketOutbox::drain(AsyncWebSocketClient* client, ClientQueue& queue) {
+    while (!queue.pending.empty() && !client->queueIsFull()) {
+        Pending& next = queue.pending.front();
+        if (!(next.binary ? client->binary(next.buffer) : client->text(next.buffer))) {
+            break;
+        }
+        queue.bytes -= next.buffer->size();
+        queue.pending.pop_front();
+    }
+}
+
+void WebSocketOutbox::flush() {
+    bool waiting = false;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto& entry : clients) {
+        AsyncWebSocketClient* client = entry.second.client;
+        if (!client || client->status() != WS_CONNECTED) {
+            continue;
+        }
+        drain(client, entry.second);
+        waiting = waiting || !entry.second.pending.empty();
+    }
+    xSemaphoreGive(lock);
+
+    if (!waiting) {
+        xTimerStop(flushTimer, 0);
+    }
+}
+
+void WebSocketOutbox::onDrop(OutboxDropHandler handler) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    dropHandler = handler;
+    xSemaphoreGive(lock);
+}
+
+void WebSocketOutbox::add(AsyncWebSocketClient* client) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    clients[client->id()].client = client;
+    xSemaphoreGive(lock);
+}
+
+void WebSocketOutbox::subscribe(uint32_t clientId, uint32_t mask) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = clients.find(clientId);
+    if (it != clients.end()) {
+        it->second.topics |= mask;
+    }
+    xSemaphoreGive(lock);
+}
+
+void WebSocketOutbox::unsubscribe(uint32_t clientId, uint32_t mask) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = clients.find(clientId);
+    if (it != clients.end()) {
+        it->second.topics &= ~mask;
+    }
+    xSemaphoreGive(lock);
+}
+
+bool WebSocketOutbox::hasSubscribers(uint32_t mask) {
+    bool found = false;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (const auto& entry : clients) {
+        if (entry.second.topics & mask) {
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(lock);
+    return found;
+}
+
+void WebSocketOutbox::remove(uint32_t clientId) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    clients.erase(clientId);
+    xSemaphoreGive(lock);
+}
+
+uint32_t WebSocketOutbox::getDropped() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t value = dropped;
+    xSemaphoreGive(lock);
+    return value;
+}
+
+uint32_t WebSocketOutbox::getCoalesced() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint32_t value = coalesced;
+    xSemaphoreGive(lock);
+    return value;
+}
+
+void WebSocketOutbox::statsJson(JsonObject out) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    out["dropped"] = dropped;
+    out["coalesced"] = coalesced;
+
+    JsonArray list = out["clients"].to<JsonArray>();
+    for (const auto& entry : clients) {
+        const ClientQueue& queue = entry.second;
+        JsonObject client = list.add<JsonObject>();
+        client["id"] = entry.first;
+        client["queued"] = queue.pending.size();
+        client["queued_bytes"] = queue.bytes;
+        client["dropped"] = queue.dropped;
+        client["coalesced"] = queue.coalesced;
+    }
+    xSemaphoreGive(lock);
+}
@@ -0,0 +1,90 @@
+#ifndef WEBSOCKET_OUTBOX_H
+#define WEBSOCKET_OUTBOX_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <deque>
+#include <functional>
+#include <map>
+
+// Bytes held back per client while its socket queue is full
+#define WS_OUTBOX_BUDGET (8 * 1024)
+// How often held-back messages are retried
+#define WS_OUTBOX_FLUSH_MS 50
+
+// Told about every message shed for a client, with the key it was queued under
+typedef std::function<void(uint32_t clientId, const String& key)> OutboxDropHandler;
+
+// Per-client outbound queues for one socket. A message goes straight to the
+// client's socket queue when that has room; otherwise it waits here, where a
+// newer message on the same topic replaces the waiting one and the oldest
+// messages are dropped once the client's byte budget is spent. A slow client
+// thus costs at most the budget and always receives the latest values.
+//
+// Producers run on other tasks than AsyncTCP, so clients are only reached
+// through the pointers registered here by add(). They are used under lock,
+// and remove() takes it too before the server frees the client.
+class WebSocketOutbox {
+private:
+    struct Pending {
+        String key;     // coalescing key, empty for none
+        AsyncWebSocketSharedBuffer buffer;
+        bool binary;
+    };
+
+    struct ClientQueue {
+        AsyncWebSocketClient* client = nullptr;
+        std::deque<Pending> pending;
+        size_t bytes = 0;
+        uint32_t dropped = 0;
+        uint32_t coalesced = 0;
+        uint32_t topics = 0;   // WebSocketHub topic bits the client subscribed to
+    };
+
+    AsyncWebSocket* ws;
+    std::map<uint32_t, ClientQueue> clients;
+    uint32_t dropped;
+    uint32_t coalesced;
+    SemaphoreHandle_t lock;
+    TimerHandle_t flushTimer;
+    OutboxDropHandler dropHandler;
+
+    static void onFlushTimer(TimerHandle_t timer);
+    void enqueue(uint32_t clientId, ClientQueue& queue, const String& key, AsyncWebSocketSharedBuffer buffer, bool binary);
+    void shed(uint32_t clientId, ClientQueue& queue, const String& key);
+    void drain(AsyncWebSocketClient* client, ClientQueue& queue);
+
+public:
+    explicit WebSocketOutbox(AsyncWebSocket* ws);
+
+    // Registers a connected client; call from its WS_EVT_CONNECT
+    void add(AsyncWebSocketClient* client);
+
+    // Delivers or queues buffer for every connected client, or with a
+    // nonzero mask only for clients subscribed to one of its topic bits.
+    // Waiting messages with the same key are coalesced; an empty key never
+    // is. Returns how many clients got it immediately.
+    size_t publish(const String& key, AsyncWebSocketSharedBuffer buffer, bool binary = false, uint32_t mask = 0);
+    
+    // Same for a single client, for payloads built per client
+    bool send(uint32_t clientId, const String& key, AsyncWebSocketSharedBuffer buffer, bool binary = false);
+    
+    // Called with the outbox locked, so it must not use the outbox itself
+    void onDrop(OutboxDropHandler handler);
+
+    void subscribe(uint32_t clientId, uint32_t mask);
+    void unsubscribe(uint32_t clientId, uint32_t mask);
+    bool hasSubscribers(uint32_t mask);
+
+    // Moves held-back messages to clients whose socket queue has room
+    void flush();
+    // Call from WS_EVT_DISCONNECT, before the server frees the client
+    void remove(uint32_t clientId);
+
+    uint32_t getDropped();
+    uint32_t getCoalesced();
+    void statsJson(JsonObject out);
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "WebSocketRequest.h"
+#include "WebSocketBroadcast.h"
+#include "WebSocketHub.h"
 
 WebSocketRequest::WebSocketRequest(AsyncWebSocket* webSocket, AsyncWebSocketClient* wsClient) 
     : ws(webSocket), client(wsClient) {
@@ -69,13 +71,19 @@ void WebSocketRequest::close(uint16_t code, const String& reason) {
 }
 
 void WebSocketRequest::broadcast(const String& message) {
-    if (ws) {
-        ws->textAll(message);
-    }
+    WebSocketBroadcast::send(ws, WebSocketBroadcast::makeBuffer(message));
 }
 
 void WebSocketRequest::broadcast(uint8_t* data, size_t length) {
-    if (ws) {
-        ws->binaryAll(data, length);
+    WebSocketBroadcast::send(ws, WebSocketBroadcast::makeBuffer(data, length), true);
+}
+
+bool WebSocketRequest::subscribe(const String& topic) {
+    return client && WebSocketHub::getInstance()->subscribe(ws, client->id(), topic);
+}
+
+void WebSocketRequest::unsubscribe(const String& topic) {
+    if (client) {
+        WebSocketHub::getInstance()->unsubscribe(ws, client->id(), topic);
     }
 }
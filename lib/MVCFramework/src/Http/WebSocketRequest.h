@@ -42,6 +42,10 @@ public:
     void broadcast(const String& message);
     void broadcast(uint8_t* data, size_t length);
     
+    // WebSocketHub topics this client receives
+    bool subscribe(const String& topic);
+    void unsubscribe(const String& topic);
+    
     // Get underlying objects for advanced usage
     AsyncWebSocket* getWebSocket() const { return ws; }
     AsyncWebSocketClient* getClient() const { return client; }
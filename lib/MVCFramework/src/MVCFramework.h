@@ -9,10 +9,18 @@
 #include "Routing/Router.h"
 
 #include "Http/Middleware.h"
+#include "Http/RateLimitTable.h"
 #include "Http/Request.h"
 #include "Http/Response.h"
 #include "Http/Controller.h"
 #include "Http/WebSocketRequest.h"
+#include "Http/AuthToken.h"
+#include "Http/ResponseCache.h"
+#include "Http/WebSocketBroadcast.h"
+#include "Http/WebSocketOutbox.h"
+#include "Http/WebSocketAssembler.h"
+#include "Http/WebSocketHub.h"
+#include "Http/LiveState.h"
 
 #include "View/View.h"
 
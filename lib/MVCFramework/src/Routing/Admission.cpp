@@ -0,0 +1,55 @@
+#include "Admission.h"
+
+AdmissionGate::AdmissionGate(uint8_t concurrency, uint8_t queue, uint16_t retryAfterSeconds)
+    : maxActive(concurrency > 0 ? concurrency : 1), maxQueued(queue), retryAfter(retryAfterSeconds),
+      active(0), rejected(0), lock(xSemaphoreCreateMutex()) {
+}
+
+bool AdmissionGate::enter() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool admitted = active < maxActive;
+    if (admitted) {
+        active++;
+    } else {
+        rejected++;
+    }
+    xSemaphoreGive(lock);
+    return admitted;
+}
+
+Admission AdmissionGate::submit(std::function<void()> job) {
+    Admission result;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (active < maxActive) {
+        active++;
+        result = Admission::Run;
+    } else if (pending.size() < maxQueued) {
+        pending.push_back(std::move(job));
+        result = Admission::Queued;
+    } else {
+        rejected++;
+        result = Admission::Rejected;
+    }
+    xSemaphoreGive(lock);
+
+    return result;
+}
+
+void AdmissionGate::leave() {
+    std::function<void()> next;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (!pending.empty()) {
+        // The slot passes to the queued job, so active stays the same
+        next = std::move(pending.front());
+        pending.pop_front();
+    } else if (active > 0) {
+        active--;
+    }
+    xSemaphoreGive(lock);
+
+    if (next) {
+        next();
+    }
+}
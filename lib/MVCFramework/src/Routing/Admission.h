@@ -0,0 +1,43 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+
+enum class Admission : uint8_t {
+    Run,      // a slot was free; the caller runs the work now
+    Queued,   // parked until a running request of the group finishes
+    Rejected  // group and its queue are full; answer 503
+};
+
+// Concurrency limit shared by the routes of one group. Inline handlers can
+// only take a free slot, since waiting would stall the AsyncTCP task;
+// deferred handlers may also wait in a bounded FIFO.
+class AdmissionGate {
+private:
+    uint8_t maxActive;
+    uint8_t maxQueued;
+    uint16_t retryAfter;
+    uint8_t active;
+    std::deque<std::function<void()>> pending;
+    uint32_t rejected;
+    SemaphoreHandle_t lock;
+
+public:
+    AdmissionGate(uint8_t concurrency, uint8_t queue, uint16_t retryAfterSeconds);
+
+    // Inline request: takes a slot, or returns false when none is free
+    bool enter();
+    // Deferred request: job is stored and run by leave() when it was queued
+    Admission submit(std::function<void()> job);
+    // Frees the slot, handing it straight to the oldest queued job if any
+    void leave();
+
+    uint16_t getRetryAfter() const { return retryAfter; }
+    uint8_t getActive() const { return active; }
+    size_t getQueued() const { return pending.size(); }
+    uint32_t getRejected() const { return rejected; }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "RouteTrie.h"
+
+static const uint16_t NO_NODE = 0xFFFF;
+
+HttpMethod toHttpMethod(WebRequestMethodComposite method) {
+    switch (method) {
+        case HTTP_GET: return HttpMethod::Get;
+        case HTTP_POST: return HttpMethod::Post;
+        case HTTP_PUT: return HttpMethod::Put;
+        case HTTP_DELETE: return HttpMethod::Delete;
+        case HTTP_PATCH: return HttpMethod::Patch;
+        default: return HttpMethod::Get;
+    }
+}
+
+const char* httpMethodName(HttpMethod method) {
+    switch (method) {
+        case HttpMethod::Get: return "GET";
+        case HttpMethod::Post: return "POST";
+        case HttpMethod::Put: return "PUT";
+        case HttpMethod::Patch: return "PATCH";
+        case HttpMethod::Delete: return "DELETE";
+        default: return "UNKNOWN";
+    }
+}
+
+RouteTrie::RouteTrie() {
+    clear();
+}
+
+void RouteTrie::clear() {
+    nodes.clear();
+    nodes.emplace_back(); // Root node represents "/"
+}
+
+uint16_t RouteTrie::staticChild(uint16_t node, const char* segment, size_t length) const {
+    for (uint16_t child : nodes[node].children) {
+        const String& candidate = nodes[child].segment;
+        if (candidate.length() == length && memcmp(candidate.c_str(), segment, length) == 0) {
+            return child;
+        }
+    }
+    return NO_NODE;
+}
+
+bool RouteTrie::insert(HttpMethod method, const String& path, int routeIndex) {
+    uint16_t node = 0;
+    size_t paramCount = 0;
+    size_t length = path.length();
+    const char* str = path.c_str();
+    size_t pos = 0;
+
+    while (pos < length) {
+        if (str[pos] == '/') {
+            pos++;
+            continue;
+        }
+
+        size_t end = pos;
+        while (end < length && str[end] != '/') end++;
+
+        size_t segmentLength = end - pos;
+        if (str[pos] == '{' && str[end - 1] == '}') {
+            if (++paramCount > ROUTE_MAX_PARAMS) {
+                return false;
+            }
+            if (nodes[node].paramChild < 0) {
+                nodes.emplace_back();
+                nodes[node].paramChild = nodes.size() - 1;
+            }
+            node = nodes[node].paramChild;
+        } else {
+            uint16_t child = staticChild(node, str + pos, segmentLength);
+            if (child == NO_NODE) {
+                nodes.emplace_back();
+                child = nodes.size() - 1;
+                nodes[child].segment = path.substring(pos, end);
+                nodes[node].children.push_back(child);
+            }
+            node = child;
+        }
+
+        pos = end;
+    }
+
+    int16_t& slot = nodes[node].routes[(size_t)method];
+    if (slot >= 0) {
+        return false;
+    }
+    slot = routeIndex;
+    return true;
+}
+
+bool RouteTrie::match(HttpMethod method, const char* path, size_t length, RouteMatch& match) const {
+    match.routeIndex = -1;
+    match.paramCount = 0;
+    return matchFrom(0, (size_t)method, path, 0, length, match);
+}
+
+bool RouteTrie::matchFrom(uint16_t node, size_t methodIndex, const char* path, size_t pos, size_t length, RouteMatch& match) const {
+    while (pos < length && path[pos] == '/') pos++;
+
+    if (pos >= length) {
+        int16_t routeIndex = nodes[node].routes[methodIndex];
+        if (routeIndex < 0) {
+            return false;
+        }
+        match.routeIndex = routeIndex;
+        return true;
+    }
+
+    size_t end = pos;
+    while (end < length && path[end] != '/') end++;
+
+    // Static segments win over placeholders; fall back to the placeholder
+    // branch if the static subtree has no route for the rest of the path.
+    uint16_t child = staticChild(node, path + pos, end - pos);
+    if (child != NO_NODE && matchFrom(child, methodIndex, path, end, length, match)) {
+        return true;
+    }
+
+    int16_t paramChild = nodes[node].paramChild;
+    if (paramChild >= 0 && match.paramCount < ROUTE_MAX_PARAMS) {
+        RouteParamSlice& slice = match.params[match.paramCount++];
+        slice.offset = pos;
+        slice.length = end - pos;
+        if (matchFrom(paramChild, methodIndex, path, end, length, match)) {
+            return true;
+        }
+        match.paramCount--;
+    }
+
+    return false;
+}
@@ -0,0 +1,72 @@
+#ifndef ROUTE_TRIE_H
+#define ROUTE_TRIE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <vector>
+
+enum class HttpMethod : uint8_t {
+    Get = 0,
+    Post,
+    Put,
+    Patch,
+    Delete,
+    Count
+};
+
+HttpMethod toHttpMethod(WebRequestMethodComposite method);
+const char* httpMethodName(HttpMethod method);
+
+// Maximum number of {placeholders} a single route may declare
+#define ROUTE_MAX_PARAMS 4
+
+// A route parameter value as a slice of the matched path (no copy)
+struct RouteParamSlice {
+    uint16_t offset;
+    uint16_t length;
+};
+
+struct RouteMatch {
+    int routeIndex = -1;
+    uint8_t paramCount = 0;
+    RouteParamSlice params[ROUTE_MAX_PARAMS];
+};
+
+// Segment trie over registered route paths. Built once when the router is
+// initialized; matching walks the path in place without allocating.
+// Static segments take precedence over {placeholders} at the same depth.
+class RouteTrie {
+private:
+    struct Node {
+        String segment;
+        std::vector<uint16_t> children;
+        int16_t paramChild = -1;
+        int16_t routes[(size_t)HttpMethod::Count];
+
+        Node() {
+            for (size_t i = 0; i < (size_t)HttpMethod::Count; i++) {
+                routes[i] = -1;
+            }
+        }
+    };
+
+    std::vector<Node> nodes;
+
+    uint16_t staticChild(uint16_t node, const char* segment, size_t length) const;
+    bool matchFrom(uint16_t node, size_t methodIndex, const char* path, size_t pos, size_t length, RouteMatch& match) const;
+
+public:
+    RouteTrie();
+
+    void clear();
+
+    // Returns false if the method/path pair is already taken or the path
+    // declares more than ROUTE_MAX_PARAMS placeholders.
+    bool insert(HttpMethod method, const String& path, int routeIndex);
+
+    bool match(HttpMethod method, const char* path, size_t length, RouteMatch& match) const;
+
+    size_t size() const { return nodes.size(); }
+};
+
+#endif
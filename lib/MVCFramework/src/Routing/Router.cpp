@@ -3,42 +3,119 @@
 #include "../Http/Response.h"
 #include "../Http/WebSocketRequest.h"
 #include "../Http/Middleware.h"
-#include <regex>
+#include "../Http/WebSocketBroadcast.h"
+#include "../Http/WebSocketHub.h"
+#include <SerialDebug.h>
+#include <atomic>
+#include <memory>
 
-Router::Router(AsyncWebServer* webServer) : server(webServer) {
+const uint32_t ROUTE_LATENCY_BOUNDS_US[ROUTE_LATENCY_BUCKETS] = {
+    250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+
+uint32_t RouteMetrics::percentileUs(float quantile) const {
+    uint32_t count = 0;
+    for (uint32_t bucket : latencyBuckets) count += bucket;
+    if (count == 0) return 0;
+    
+    // Report the upper bound of the bucket holding the requested rank
+    uint32_t rank = (uint32_t)(quantile * count + 0.5f);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < ROUTE_LATENCY_BUCKETS; i++) {
+        seen += latencyBuckets[i];
+        if (seen >= rank) {
+            return ROUTE_LATENCY_BOUNDS_US[i] < latencyMaxUs ? ROUTE_LATENCY_BOUNDS_US[i] : latencyMaxUs;
+        }
+    }
+    return latencyMaxUs;
+}
+
+// A request handed to the worker pool. The server request is paused and only
+// ever touched on the AsyncTCP task: the worker reads the detached copy and
+// leaves its Response here for drainDeferred() to send.
+struct DeferredRequest {
+    AsyncWebServerRequestPtr handle; // expires when the server frees the request
+    AsyncWebServerRequest* request;  // valid only while handle can be locked
+    Request input;
+    Route* route;
+    uint32_t startUs;
+    std::atomic<bool> disconnected;
+    bool overloaded = false;
+    std::unique_ptr<Response> response;
+    
+    DeferredRequest(AsyncWebServerRequest* serverRequest) : request(serverRequest), input(serverRequest), disconnected(false) {}
+};
+
+Router::Router(AsyncWebServer* webServer) : server(webServer), completedLock(xSemaphoreCreateMutex()) {
 }
 
 Router& Router::get(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("GET", path, handler);
+    addRoute(HttpMethod::Get, path, handler);
 		return *this;
 }
 
 Router& Router::post(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("POST", path, handler);
+    addRoute(HttpMethod::Post, path, handler);
 		return *this;
 }
 
 Router& Router::put(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("PUT", path, handler);
+    addRoute(HttpMethod::Put, path, handler);
 		return *this;
 }
 
 Router& Router::patch(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("PATCH", path, handler);
+    addRoute(HttpMethod::Patch, path, handler);
 		return *this;
 }
 
 Router& Router::delete_(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("DELETE", path, handler);
+    addRoute(HttpMethod::Delete, path, handler);
 		return *this;
 }
 
 Router& Router::any(const String& path, std::function<Response(Request&)> handler) {
-    addRoute("GET", path, handler);
-    addRoute("POST", path, handler);
-    addRoute("PUT", path, handler);
-    addRoute("PATCH", path, handler);
-    addRoute("DELETE", path, handler);
+    addRoute(HttpMethod::Get, path, handler);
+    addRoute(HttpMethod::Post, path, handler);
+    addRoute(HttpMethod::Put, path, handler);
+    addRoute(HttpMethod::Patch, path, handler);
+    addRoute(HttpMethod::Delete, path, handler);
+    return *this;
+}
+
+Router& Router::getAsync(const String& path, std::function<Response(Request&)> handler) {
+    addRoute(HttpMethod::Get, path, handler).deferred = true;
+    return *this;
+}
+
+Router& Router::postAsync(const String& path, std::function<Response(Request&)> handler) {
+    addRoute(HttpMethod::Post, path, handler).deferred = true;
+    return *this;
+}
+
+Router& Router::putAsync(const String& path, std::function<Response(Request&)> handler) {
+    addRoute(HttpMethod::Put, path, handler).deferred = true;
+    return *this;
+}
+
+Router& Router::patchAsync(const String& path, std::function<Response(Request&)> handler) {
+    addRoute(HttpMethod::Patch, path, handler).deferred = true;
+    return *this;
+}
+
+Router& Router::deleteAsync(const String& path, std::function<Response(Request&)> handler) {
+    addRoute(HttpMethod::Delete, path, handler).deferred = true;
+    return *this;
+}
+
+Router& Router::workerPool(uint8_t workers, BaseType_t core, uint32_t stackSize) {
+    if (initialized) {
+        LOG_WARNING("[Router] workerPool() after init() has no effect");
+    }
+    workerCount = workers > 0 ? workers : 1;
+    workerCore = core;
+    workerStack = stackSize;
     return *this;
 }
 
@@ -79,12 +156,14 @@ Router& Router::onBinary(std::function<void(WebSocketRequest&, uint8_t*, size_t)
 Router& Router::group(const String& groupPrefix, std::function<void(Router&)> routeFunc) {
     String oldPrefix = prefix;
     std::vector<String> oldMiddleware = middlewareStack;
+    std::shared_ptr<AdmissionGate> oldGate = currentGate;
     
     prefix = oldPrefix + groupPrefix;
     routeFunc(*this);
     
     prefix = oldPrefix;
     middlewareStack = oldMiddleware;
+    currentGate = oldGate;
     return *this;
 }
 
@@ -100,13 +179,32 @@ Router& Router::middleware(const std::vector<String>& names) {
     return *this;
 }
 
+Router& Router::limit(uint8_t concurrency, uint8_t queue, uint16_t retryAfterSeconds) {
+    currentGate = std::make_shared<AdmissionGate>(concurrency, queue, retryAfterSeconds);
+    return *this;
+}
+
+Router& Router::defer() {
+    if (!initialized && !routes.empty()) {
+        routes.back().deferred = true;
+    }
+    return *this;
+}
+
 Router& Router::name(const String& routeName) {
-    if (!routes.empty()) {
+    if (!initialized && !routes.empty()) {
         routes.back().name = routeName;
     }
     return *this;
 }
 
+Router& Router::onBody(BodyChunkHandler handler) {
+    if (!initialized && !routes.empty()) {
+        routes.back().bodyHandler = handler;
+    }
+    return *this;
+}
+
 String Router::route(const String& name, const std::map<String, String>& parameters) {
     for (const Route& route : routes) {
         if (route.name == name) {
@@ -125,12 +223,31 @@ void Router::registerMiddleware(const String& name, std::shared_ptr<Middleware>
     middlewares[name] = middleware;
 }
 
-Route& Router::addRoute(const String& method, const String& path, std::function<Response(Request&)> handler) {
+Route& Router::addRoute(HttpMethod method, const String& path, std::function<Response(Request&)> handler) {
     Route route;
     route.method = method;
     route.path = prefix + path;
     route.handler = handler;
     route.middleware = middlewareStack;
+    route.gate = currentGate;
+    
+    // Record placeholder names in order; matching yields values in the same order
+    int open = route.path.indexOf('{');
+    while (open >= 0) {
+        int close = route.path.indexOf('}', open);
+        if (close < 0) break;
+        route.parameterNames.push_back(route.path.substring(open + 1, close));
+        open = route.path.indexOf('{', close);
+    }
+    
+    // The route table and in-flight requests hold pointers into routes, so
+    // it must not grow once serving has started
+    if (initialized) {
+        LOG_ERROR("[Router] Route %s %s registered after init() was rejected",
+                  httpMethodName(method), route.path.c_str());
+        rejectedRoute = route;
+        return rejectedRoute;
+    }
     
     routes.push_back(route);
     return routes.back();
@@ -141,11 +258,14 @@ WebSocketRoute& Router::addWebSocketRoute(const String& path) {
     wsRoute.path = prefix + path;
     wsRoute.middleware = middlewareStack;
     
-    wsRoutes.push_back(wsRoute);
-    
     // Create and register AsyncWebSocket
     AsyncWebSocket* ws = new AsyncWebSocket(wsRoute.path);
     webSockets[wsRoute.path] = ws;
+    wsRoute.outbox = std::make_shared<WebSocketOutbox>(ws);
+    wsRoute.assembler = std::make_shared<WebSocketAssembler>();
+    WebSocketHub::getInstance()->attach(ws, wsRoute.outbox.get());
+    
+    wsRoutes.push_back(wsRoute);
     
     // Set up event handler
     ws->onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
@@ -158,185 +278,289 @@ WebSocketRoute& Router::addWebSocketRoute(const String& path) {
     return wsRoutes.back();
 }
 
-bool Router::matchRoute(const Route& route, const String& method, const String& path, std::map<String, String>& params) {
-    if (route.method != method && route.method != "ANY") {
-        return false;
+void Router::buildRouteTable() {
+    routeTrie.clear();
+    
+    for (size_t i = 0; i < routes.size(); i++) {
+        const Route& route = routes[i];
+        if (!routeTrie.insert(route.method, route.path, i)) {
+            LOG_WARNING("[Router] Skipping route %s %s: duplicate path or too many parameters",
+                        httpMethodName(route.method), route.path.c_str());
+        }
+    }
+    
+    LOG_INFO("[Router] %u routes compiled into %u trie nodes", (unsigned)routes.size(), (unsigned)routeTrie.size());
+}
+
+// "name:parameters" references get their own instance, configured once
+// and shared by every route that uses the same reference
+std::map<String, std::shared_ptr<Middleware>>::iterator Router::configureMiddleware(const String& reference) {
+    int colon = reference.indexOf(':');
+    if (colon < 0) {
+        return middlewares.end();
     }
     
-    // Exact match first (no parameters)
-    if (route.path == path) {
-        return true;
+    auto base = middlewares.find(reference.substring(0, colon));
+    if (base == middlewares.end()) {
+        return middlewares.end();
     }
     
-    // Check for parameters in route
-    if (route.path.indexOf('{') >= 0) {
-        // Split both paths into segments
-        std::vector<String> routeSegments;
-        std::vector<String> pathSegments;
-        
-        // Parse route path segments
-        String routeCopy = route.path;
-        if (routeCopy.startsWith("/")) routeCopy = routeCopy.substring(1);
-        if (routeCopy.endsWith("/")) routeCopy = routeCopy.substring(0, routeCopy.length() - 1);
+    std::shared_ptr<Middleware> configured = base->second->configure(reference.substring(colon + 1));
+    if (!configured) {
+        return middlewares.end();
+    }
+    return middlewares.emplace(reference, configured).first;
+}
+
+void Router::resolveMiddleware() {
+    size_t unresolved = 0;
+    
+    for (Route& route : routes) {
+        route.pipeline.clear();
+        route.pipeline.reserve(route.middleware.size());
         
-        int start = 0;
-        for (int i = 0; i <= routeCopy.length(); i++) {
-            if (i == routeCopy.length() || routeCopy.charAt(i) == '/') {
-                if (i > start) {
-                    routeSegments.push_back(routeCopy.substring(start, i));
-                }
-                start = i + 1;
+        for (const String& middlewareName : route.middleware) {
+            auto it = middlewares.find(middlewareName);
+            if (it == middlewares.end()) {
+                it = configureMiddleware(middlewareName);
             }
-        }
-        
-        // Parse request path segments
-        String pathCopy = path;
-        if (pathCopy.startsWith("/")) pathCopy = pathCopy.substring(1);
-        if (pathCopy.endsWith("/")) pathCopy = pathCopy.substring(0, pathCopy.length() - 1);
-        
-        start = 0;
-        for (int i = 0; i <= pathCopy.length(); i++) {
-            if (i == pathCopy.length() || pathCopy.charAt(i) == '/') {
-                if (i > start) {
-                    pathSegments.push_back(pathCopy.substring(start, i));
-                }
-                start = i + 1;
+            if (it == middlewares.end()) {
+                LOG_ERROR("[Router] Unknown middleware '%s' on route %s %s",
+                          middlewareName.c_str(), httpMethodName(route.method), route.path.c_str());
+                unresolved++;
+                continue;
             }
+            route.pipeline.push_back(it->second.get());
         }
-        
-        // Must have same number of segments
-        if (routeSegments.size() != pathSegments.size()) {
-            return false;
-        }
-        
-        // Match each segment
-        for (size_t i = 0; i < routeSegments.size(); i++) {
-            String routeSegment = routeSegments[i];
-            String pathSegment = pathSegments[i];
-            
-            if (routeSegment.startsWith("{") && routeSegment.endsWith("}")) {
-                // This is a parameter, extract it
-                String paramName = routeSegment.substring(1, routeSegment.length() - 1);
-                params[paramName] = pathSegment;
-            } else if (routeSegment != pathSegment) {
-                // Static segment must match exactly
-                return false;
-            }
-        }
-        
-        return true;
     }
     
-    return false;
+    if (unresolved > 0) {
+        // Loud at boot, but the routes stay up, running the middleware that did resolve
+        LOG_ERROR("[Router] %u unknown middleware reference(s); affected routes run without them",
+                  (unsigned)unresolved);
+    }
 }
 
 void Router::init() {
+    // Freeze the route table; routes added after this point are not matched
+    buildRouteTable();
+    resolveMiddleware();
+    initialized = true;
+    
+    Response::beginFileETags();
+    for (const Route& route : routes) {
+        if (route.deferred) {
+            if (!workers.begin(workerCount, workerCore, workerStack, ROUTER_WORKER_PRIORITY)) {
+                LOG_ERROR("[Router] Could not start request workers; deferred routes will respond 503");
+            }
+            break;
+        }
+    }
+    
     // Register all routes with the AsyncWebServer
     server->onNotFound([this](AsyncWebServerRequest* request) {
         handleRequest(request);
     });
     
+    server->onRequestBody([this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+        handleRequestBody(request, data, len, index, total);
+    });
+    
     server->begin();
 }
 
-void Router::handleRequest(AsyncWebServerRequest* request) {
-    String method;
-    switch (request->method()) {
-        case HTTP_GET: method = "GET"; break;
-        case HTTP_POST: method = "POST"; break;
-        case HTTP_PUT: method = "PUT"; break;
-        case HTTP_DELETE: method = "DELETE"; break;
-        case HTTP_PATCH: method = "PATCH"; break;
-        default: method = "GET"; break;
+Route* Router::findRoute(AsyncWebServerRequest* request, RouteMatch& match) {
+    // Match against the URL buffer in place, ignoring any query string
+    const String& url = request->url();
+    const char* path = url.c_str();
+    const char* query = strchr(path, '?');
+    size_t pathLength = query ? (size_t)(query - path) : url.length();
+    
+    if (!routeTrie.match(toHttpMethod(request->method()), path, pathLength, match)) {
+        return nullptr;
     }
+    return &routes[match.routeIndex];
+}
+
+void Router::handleRequestBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+    drainDeferred();
     
-    String path = request->url();
+    RouteMatch match;
+    const Route* route = findRoute(request, match);
     
-    // Remove query string from path
-    int queryIndex = path.indexOf('?');
-    if (queryIndex >= 0) {
-        path = path.substring(0, queryIndex);
+    // Streaming routes consume chunks directly; everything else is buffered
+    if (route && route->bodyHandler) {
+        route->bodyHandler(request, data, len, index, total);
+        return;
     }
+    Request::appendBodyChunk(request, data, len, index, total);
+}
+
+void Router::handleRequest(AsyncWebServerRequest* request) {
+    uint32_t startUs = micros();
+    const char* methodName = httpMethodName(toHttpMethod(request->method()));
     
-    Serial.println("[DEBUG] Router handling: " + method + " " + path);
+    drainDeferred();
     
-    // Find matching route - sort routes by specificity (routes without parameters first)
-    std::vector<const Route*> candidateRoutes;
+    LOG_DEBUG("[Router] %s %s", methodName, request->url().c_str());
     
-    // First pass: exact matches (no parameters)
-    for (const Route& route : routes) {
-        if (route.method == method && route.path == path) {
-            candidateRoutes.push_back(&route);
-            break; // Exact match found, use it
+    RouteMatch match;
+    Route* matchedRoute = findRoute(request, match);
+    if (matchedRoute) {
+        if (matchedRoute->deferred) {
+            handleDeferred(request, *matchedRoute, match, startUs);
+            return;
         }
-    }
-    
-    // Second pass: parametric routes if no exact match
-    if (candidateRoutes.empty()) {
-        for (const Route& route : routes) {
-            if (route.method == method && route.path.indexOf('{') >= 0) {
-                std::map<String, String> params;
-                if (matchRoute(route, method, path, params)) {
-                    candidateRoutes.push_back(&route);
-                    // For parametric routes, use the first match
-                    break;
-                }
-            }
+        
+        // Inline handlers run on the AsyncTCP task and cannot wait for a slot
+        AdmissionGate* gate = matchedRoute->gate.get();
+        if (gate && !gate->enter()) {
+            sendOverloaded(request, *matchedRoute, startUs);
+            return;
         }
-    }
-    
-    if (!candidateRoutes.empty()) {
-        const Route* matchedRoute = candidateRoutes[0];
         
         // Create request object
         Request req(request);
         
-        // Set route parameters for parametric routes
-        if (matchedRoute->path.indexOf('{') >= 0) {
-            std::map<String, String> params;
-            matchRoute(*matchedRoute, method, path, params);
-            for (const auto& param : params) {
-                req.setRouteParameter(param.first, param.second);
-            }
-        }
+        // Route parameters stay as slices of the URL until a handler reads them
+        req.setRouteParameters(matchedRoute->parameterNames, match);
         
         // Execute middleware chain
-        Response response = executeMiddleware(matchedRoute->middleware, req, matchedRoute->handler);
+        Response response = Next(matchedRoute, 0)(req);
         
         // Send response
         response.send();
+        recordMetrics(*matchedRoute, response.getStatusCode(), micros() - startUs);
+        
+        if (gate) {
+            gate->leave();
+        }
         return;
     }
     
     // No route found
-    Serial.println("[DEBUG] No route found for: " + method + " " + path);
+    portENTER_CRITICAL(&metricsLock);
+    unmatchedRequests++;
+    portEXIT_CRITICAL(&metricsLock);
+    LOG_DEBUG("[Router] No route found for: %s %s", methodName, request->url().c_str());
     request->send(404, "text/plain", "Not Found");
 }
 
-Response Router::executeMiddleware(const std::vector<String>& middleware, Request& request, std::function<Response(Request&)> finalHandler) {
-    if (middleware.empty()) {
-        return finalHandler(request);
+void Router::sendOverloaded(AsyncWebServerRequest* request, Route& route, uint32_t startUs) {
+    uint16_t retryAfter = route.gate ? route.gate->getRetryAfter() : 5;
+    
+    JsonDocument error;
+    error["error"] = "Service Unavailable";
+    error["message"] = "Server busy, try again later";
+    error["retry_after"] = retryAfter;
+    
+    LOG_WARNING("[Router] Shedding %s %s", httpMethodName(route.method), route.path.c_str());
+    Response(request)
+        .status(503)
+        .header(HttpHeader::RetryAfter, String(retryAfter))
+        .json(error)
+        .send();
+    recordMetrics(route, 503, micros() - startUs);
+}
+
+void Router::handleDeferred(AsyncWebServerRequest* request, Route& route, const RouteMatch& match, uint32_t startUs) {
+    std::shared_ptr<DeferredRequest> job = std::make_shared<DeferredRequest>(request);
+    job->route = &route;
+    job->startUs = startUs;
+    job->input.setRouteParameters(route.parameterNames, match);
+    
+    // Copy what the handler may read before a worker can pick the job up
+    job->input.detach();
+    
+    Admission admission = Admission::Run;
+    if (route.gate) {
+        admission = route.gate->submit([this, job]() { dispatchDeferred(job); });
     }
     
-    // Create middleware chain
-    std::function<Response(Request&)> next = finalHandler;
+    if (admission == Admission::Rejected) {
+        sendOverloaded(request, route, startUs);
+        return;
+    }
+    
+    // Hold the connection open without a response; the server would
+    // otherwise answer 501 when we return
+    job->handle = request->pause();
+    request->onDisconnect([job]() {
+        job->disconnected = true;
+    });
+    
+    // Poll fires on the AsyncTCP task about twice a second while the request
+    // waits, which bounds how long a finished response sits in the queue.
+    // This replaces the request's own poll handler, which only resumes
+    // fillers that return RESPONSE_TRY_AGAIN; none of ours do.
+    AsyncClient* client = request->client();
+    if (client) {
+        client->onPoll([](void* router, AsyncClient*) {
+            static_cast<Router*>(router)->drainDeferred();
+        }, this);
+    }
+    
+    if (admission == Admission::Run) {
+        dispatchDeferred(job);
+    }
+}
+
+void Router::dispatchDeferred(std::shared_ptr<DeferredRequest> job) {
+    if (!workers.submit([this, job]() { runDeferred(job); })) {
+        job->overloaded = true;
+        completeDeferred(job);
+    }
+}
+
+// Runs on a worker; never touches the server request
+void Router::runDeferred(std::shared_ptr<DeferredRequest> job) {
+    Route& route = *job->route;
+    
+    if (job->disconnected) {
+        LOG_DEBUG("[Router] Client left before %s %s ran", httpMethodName(route.method), route.path.c_str());
+    } else {
+        job->response.reset(new Response(Next(&route, 0)(job->input)));
+    }
+    completeDeferred(job);
+}
+
+void Router::completeDeferred(std::shared_ptr<DeferredRequest> job) {
+    // The slot is free once the handler is done; sending is the server's work
+    if (job->route->gate) {
+        job->route->gate->leave();
+    }
     
-    // Build chain in reverse order
-    for (auto it = middleware.rbegin(); it != middleware.rend(); ++it) {
-        const String& middlewareName = *it;
-        auto middlewareIt = middlewares.find(middlewareName);
+    xSemaphoreTake(completedLock, portMAX_DELAY);
+    completed.push_back(job);
+    xSemaphoreGive(completedLock);
+}
+
+// Sends finished deferred responses; runs on the AsyncTCP task only
+void Router::drainDeferred() {
+    std::vector<std::shared_ptr<DeferredRequest>> ready;
+    xSemaphoreTake(completedLock, portMAX_DELAY);
+    ready.swap(completed);
+    xSemaphoreGive(completedLock);
+    
+    for (std::shared_ptr<DeferredRequest>& job : ready) {
+        Route& route = *job->route;
         
-        if (middlewareIt != middlewares.end()) {
-            auto middleware = middlewareIt->second;
-            auto currentNext = next;
-            
-            next = [middleware, currentNext](Request& req) -> Response {
-                return middleware->handle(req, currentNext);
-            };
+        // The handle expires when the server deletes the request, which also
+        // happens on this task, so the request cannot go away mid-send
+        std::shared_ptr<AsyncWebServerRequest> alive = job->handle.lock();
+        if (!alive || job->disconnected) {
+            continue;
+        }
+        
+        if (job->overloaded) {
+            sendOverloaded(job->request, route, job->startUs);
+        } else if (job->response) {
+            job->response->send();
+            recordMetrics(route, job->response->getStatusCode(), micros() - job->startUs);
+        } else {
+            job->request->abort();
         }
     }
-    
-    return next(request);
 }
 
 void Router::handleWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
@@ -353,19 +577,25 @@ void Router::handleWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient*
     
     if (!wsRoute) return;
     
+    drainDeferred();
+    
     WebSocketRequest wsRequest(server, client);
     wsRequest.setPath(wsPath);
     
     switch (type) {
         case WS_EVT_CONNECT:
-            Serial.printf("[WebSocket] Client %u connected to %s\n", client->id(), wsPath.c_str());
+            LOG_INFO("[WebSocket] Client %u connected to %s", client->id(), wsPath.c_str());
+            WebSocketBroadcast::prepare(client);
+            wsRoute->outbox->add(client);
             if (wsRoute->onConnect) {
                 wsRoute->onConnect(wsRequest);
             }
             break;
             
         case WS_EVT_DISCONNECT:
-            Serial.printf("[WebSocket] Client %u disconnected from %s\n", client->id(), wsPath.c_str());
+            LOG_INFO("[WebSocket] Client %u disconnected from %s", client->id(), wsPath.c_str());
+            wsRoute->outbox->remove(client->id());
+            wsRoute->assembler->remove(client->id());
             if (wsRoute->onDisconnect) {
                 wsRoute->onDisconnect(wsRequest);
             }
@@ -373,48 +603,74 @@ void Router::handleWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient*
             
         case WS_EVT_DATA: {
             AwsFrameInfo* info = (AwsFrameInfo*)arg;
-            if (info->final && info->index == 0 && info->len == len) {
-                if (info->opcode == WS_TEXT) {
-                    String message = "";
-                    for (size_t i = 0; i < len; i++) {
-                        message += (char)data[i];
-                    }
-                    Serial.printf("[WebSocket] Text message from client %u: %s\n", client->id(), message.c_str());
+            wsRoute->assembler->feed(client->id(), info, data, len, [&](uint8_t opcode, uint8_t* message, size_t length) {
+                if (opcode == WS_TEXT) {
+                    String text;
+                    text.reserve(length);
+                    text.concat((const char*)message, length);
+                    LOG_DEBUG("[WebSocket] Text message from client %u: %s", client->id(), text.c_str());
                     if (wsRoute->onMessage) {
-                        wsRoute->onMessage(wsRequest, message);
+                        wsRoute->onMessage(wsRequest, text);
                     }
-                } else if (info->opcode == WS_BINARY) {
-                    Serial.printf("[WebSocket] Binary message from client %u (%zu bytes)\n", client->id(), len);
+                } else if (opcode == WS_BINARY) {
+                    LOG_DEBUG("[WebSocket] Binary message from client %u (%zu bytes)", client->id(), length);
                     if (wsRoute->onBinary) {
-                        wsRoute->onBinary(wsRequest, data, len);
+                        wsRoute->onBinary(wsRequest, message, length);
                     }
                 }
-            }
+            });
             break;
         }
         
         case WS_EVT_PONG:
-            Serial.printf("[WebSocket] Pong from client %u\n", client->id());
+            LOG_DEBUG("[WebSocket] Pong from client %u", client->id());
             break;
             
         case WS_EVT_ERROR:
-            Serial.printf("[WebSocket] Error from client %u: %s\n", client->id(), (char*)data);
+            LOG_WARNING("[WebSocket] Error from client %u: %s", client->id(), (char*)data);
             break;
     }
 }
 
 void Router::broadcastText(const String& path, const String& message) {
+    broadcast(path, WebSocketBroadcast::makeBuffer(message));
+}
+
+void Router::broadcastBinary(const String& path, uint8_t* data, size_t len) {
+    broadcast(path, WebSocketBroadcast::makeBuffer(data, len), true);
+}
+
+size_t Router::broadcastJson(const String& path, const JsonDocument& doc) {
     auto ws = webSockets.find(path);
-    if (ws != webSockets.end()) {
-        ws->second->textAll(message);
+    if (ws == webSockets.end() || ws->second->count() == 0) {
+        return 0;
     }
+    return WebSocketBroadcast::send(ws->second, WebSocketBroadcast::makeBuffer(doc));
 }
 
-void Router::broadcastBinary(const String& path, uint8_t* data, size_t len) {
+size_t Router::broadcast(const String& path, AsyncWebSocketSharedBuffer buffer, bool binary) {
     auto ws = webSockets.find(path);
-    if (ws != webSockets.end()) {
-        ws->second->binaryAll(data, len);
+    if (ws == webSockets.end()) {
+        return 0;
     }
+    return WebSocketBroadcast::send(ws->second, buffer, binary);
+}
+
+size_t Router::publish(const String& path, const String& topic, const JsonDocument& doc) {
+    auto ws = webSockets.find(path);
+    if (ws == webSockets.end() || ws->second->count() == 0) {
+        return 0;
+    }
+    return publish(path, topic, WebSocketBroadcast::makeBuffer(doc));
+}
+
+size_t Router::publish(const String& path, const String& topic, AsyncWebSocketSharedBuffer buffer, bool binary) {
+    for (WebSocketRoute& wsRoute : wsRoutes) {
+        if (wsRoute.path == path) {
+            return wsRoute.outbox->publish(topic, buffer, binary);
+        }
+    }
+    return 0;
 }
 
 void Router::sendToClient(const String& path, uint32_t clientId, const String& message) {
@@ -428,3 +684,166 @@ AsyncWebSocket* Router::getWebSocket(const String& path) {
     auto ws = webSockets.find(path);
     return ws != webSockets.end() ? ws->second : nullptr;
 }
+
+WebSocketOutbox* Router::getOutbox(const String& path) {
+    for (WebSocketRoute& wsRoute : wsRoutes) {
+        if (wsRoute.path == path) {
+            return wsRoute.outbox.get();
+        }
+    }
+    return nullptr;
+}
+
+void Router::recordMetrics(Route& route, int statusCode, uint32_t elapsedUs) {
+    size_t bucket = 0;
+    while (bucket < ROUTE_LATENCY_BUCKETS && elapsedUs > ROUTE_LATENCY_BOUNDS_US[bucket]) {
+        bucket++;
+    }
+    int statusClass = statusCode / 100 - 1;
+    
+    portENTER_CRITICAL(&metricsLock);
+    RouteMetrics& metrics = route.metrics;
+    metrics.hits++;
+    if (statusClass >= 0 && statusClass < 5) {
+        metrics.statusClasses[statusClass]++;
+    }
+    metrics.latencyBuckets[bucket]++;
+    metrics.latencyTotalUs += elapsedUs;
+    if (elapsedUs > metrics.latencyMaxUs) {
+        metrics.latencyMaxUs = elapsedUs;
+    }
+    portEXIT_CRITICAL(&metricsLock);
+}
+
+RouteMetrics Router::snapshotMetrics(const Route& route) {
+    portENTER_CRITICAL(&metricsLock);
+    RouteMetrics metrics = route.metrics;
+    portEXIT_CRITICAL(&metricsLock);
+    return metrics;
+}
+
+void Router::metricsJson(JsonDocument& doc) {
+    portENTER_CRITICAL(&metricsLock);
+    uint32_t unmatched = unmatchedRequests;
+    portEXIT_CRITICAL(&metricsLock);
+    
+    doc["uptime_ms"] = millis();
+    doc["unmatched"] = unmatched;
+    JsonObject websocket = doc["websocket"].to<JsonObject>();
+    websocket["sent"] = WebSocketBroadcast::getSent();
+    websocket["skipped"] = WebSocketBroadcast::getSkipped();
+    JsonObject sockets = websocket["sockets"].to<JsonObject>();
+    for (WebSocketRoute& wsRoute : wsRoutes) {
+        wsRoute.outbox->statsJson(sockets[wsRoute.path].to<JsonObject>());
+    }
+    JsonArray list = doc["routes"].to<JsonArray>();
+    
+    for (const Route& route : routes) {
+        RouteMetrics metrics = snapshotMetrics(route);
+        if (metrics.hits == 0) continue;
+        
+        JsonObject entry = list.add<JsonObject>();
+        entry["method"] = httpMethodName(route.method);
+        entry["path"] = route.path;
+        if (route.name.length() > 0) {
+            entry["name"] = route.name;
+        }
+        entry["hits"] = metrics.hits;
+        
+        JsonObject status = entry["status"].to<JsonObject>();
+        static const char* classNames[5] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+        for (size_t i = 0; i < 5; i++) {
+            if (metrics.statusClasses[i] > 0) {
+                status[classNames[i]] = metrics.statusClasses[i];
+            }
+        }
+        
+        JsonObject latency = entry["latency_us"].to<JsonObject>();
+        latency["avg"] = (uint32_t)(metrics.latencyTotalUs / metrics.hits);
+        latency["max"] = metrics.latencyMaxUs;
+        latency["p50"] = metrics.percentileUs(0.50f);
+        latency["p99"] = metrics.percentileUs(0.99f);
+        
+        JsonArray buckets = latency["buckets"].to<JsonArray>();
+        for (size_t i = 0; i <= ROUTE_LATENCY_BUCKETS; i++) {
+            buckets.add(metrics.latencyBuckets[i]);
+        }
+    }
+}
+
+String Router::metricsPrometheus() {
+    static const char* classNames[5] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+    String out;
+    out.reserve(256 + routes.size() * 160);
+    char line[224];
+    
+    portENTER_CRITICAL(&metricsLock);
+    uint32_t unmatched = unmatchedRequests;
+    portEXIT_CRITICAL(&metricsLock);
+    
+    out += "# HELP http_requests_unmatched_total Requests that matched no route\n";
+    out += "# TYPE http_requests_unmatched_total counter\n";
+    snprintf(line, sizeof(line), "http_requests_unmatched_total %u\n", (unsigned)unmatched);
+    out += line;
+    
+    out += "# HELP websocket_broadcast_skipped_total Broadcast messages not queued because a client's queue was full\n";
+    out += "# TYPE websocket_broadcast_skipped_total counter\n";
+    snprintf(line, sizeof(line), "websocket_broadcast_skipped_total %u\n", (unsigned)WebSocketBroadcast::getSkipped());
+    out += line;
+    
+    out += "# HELP websocket_outbox_dropped_total Queued messages dropped over a client's byte budget\n";
+    out += "# TYPE websocket_outbox_dropped_total counter\n";
+    for (WebSocketRoute& wsRoute : wsRoutes) {
+        snprintf(line, sizeof(line), "websocket_outbox_dropped_total{socket=\"%s\"} %u\n",
+                 wsRoute.path.c_str(), (unsigned)wsRoute.outbox->getDropped());
+        out += line;
+    }
+    
+    out += "# HELP websocket_outbox_coalesced_total Queued messages replaced by a newer one on the same topic\n";
+    out += "# TYPE websocket_outbox_coalesced_total counter\n";
+    for (WebSocketRoute& wsRoute : wsRoutes) {
+        snprintf(line, sizeof(line), "websocket_outbox_coalesced_total{socket=\"%s\"} %u\n",
+                 wsRoute.path.c_str(), (unsigned)wsRoute.outbox->getCoalesced());
+        out += line;
+    }
+    
+    out += "# HELP http_requests_total Requests handled per route and status class\n";
+    out += "# TYPE http_requests_total counter\n";
+    for (const Route& route : routes) {
+        RouteMetrics metrics = snapshotMetrics(route);
+        for (size_t i = 0; i < 5; i++) {
+            if (metrics.statusClasses[i] == 0) continue;
+            snprintf(line, sizeof(line), "http_requests_total{method=\"%s\",route=\"%s\",status=\"%s\"} %u\n",
+                     httpMethodName(route.method), route.path.c_str(), classNames[i], (unsigned)metrics.statusClasses[i]);
+            out += line;
+        }
+    }
+    
+    out += "# HELP http_request_duration_microseconds Route handling latency\n";
+    out += "# TYPE http_request_duration_microseconds histogram\n";
+    for (const Route& route : routes) {
+        RouteMetrics metrics = snapshotMetrics(route);
+        if (metrics.hits == 0) continue;
+        
+        const char* method = httpMethodName(route.method);
+        const char* path = route.path.c_str();
+        uint32_t cumulative = 0;
+        for (size_t i = 0; i < ROUTE_LATENCY_BUCKETS; i++) {
+            cumulative += metrics.latencyBuckets[i];
+            snprintf(line, sizeof(line), "http_request_duration_microseconds_bucket{method=\"%s\",route=\"%s\",le=\"%u\"} %u\n",
+                     method, path, (unsigned)ROUTE_LATENCY_BOUNDS_US[i], (unsigned)cumulative);
+            out += line;
+        }
+        snprintf(line, sizeof(line), "http_request_duration_microseconds_bucket{method=\"%s\",route=\"%s\",le=\"+Inf\"} %u\n",
+                 method, path, (unsigned)metrics.hits);
+        out += line;
+        snprintf(line, sizeof(line), "http_request_duration_microseconds_sum{method=\"%s\",route=\"%s\"} %llu\n",
+                 method, path, (unsigned long long)metrics.latencyTotalUs);
+        out += line;
+        snprintf(line, sizeof(line), "http_request_duration_microseconds_count{method=\"%s\",route=\"%s\"} %u\n",
+                 method, path, (unsigned)metrics.hits);
+        out += line;
+    }
+    
+    return out;
+}
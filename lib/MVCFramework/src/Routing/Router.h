@@ -3,9 +3,15 @@
 
 #include <Arduino.h>
 #include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
 #include <map>
 #include <vector>
 #include <functional>
+#include "RouteTrie.h"
+#include "Admission.h"
+#include "WorkerPool.h"
+#include "../Http/WebSocketOutbox.h"
+#include "../Http/WebSocketAssembler.h"
 
 // Forward declarations
 class Request;
@@ -13,14 +19,46 @@ class Response;
 class Middleware;
 class WebSocketRequest;
 class WebSocketResponse;
+struct DeferredRequest;
+
+// Default pool for deferred handlers, started by init() when a route needs it
+#define ROUTER_WORKERS 1
+#define ROUTER_WORKER_CORE 0
+#define ROUTER_WORKER_STACK 8192
+#define ROUTER_WORKER_PRIORITY 2
+
+// Upper bounds (microseconds) of the latency histogram buckets; one extra
+// bucket counts everything slower than the last bound.
+#define ROUTE_LATENCY_BUCKETS 12
+extern const uint32_t ROUTE_LATENCY_BOUNDS_US[ROUTE_LATENCY_BUCKETS];
+
+struct RouteMetrics {
+    uint32_t hits = 0;
+    uint32_t statusClasses[5] = {0};                       // 1xx .. 5xx
+    uint32_t latencyBuckets[ROUTE_LATENCY_BUCKETS + 1] = {0};
+    uint64_t latencyTotalUs = 0;
+    uint32_t latencyMaxUs = 0;
+    
+    uint32_t percentileUs(float quantile) const;
+};
+
+// Receives request body chunks as they arrive, instead of the body being
+// buffered for the handler. index is the offset of data within the body.
+typedef std::function<void(AsyncWebServerRequest* request, const uint8_t* data, size_t len, size_t index, size_t total)> BodyChunkHandler;
 
 struct Route {
-    String method;
+    HttpMethod method;
     String path;
     std::function<Response(Request&)> handler;
+    BodyChunkHandler bodyHandler;
     std::vector<String> middleware;
+    std::vector<Middleware*> pipeline;  // middleware resolved by init(), in call order
+    bool deferred = false;              // handler runs on a worker task, see Router::defer()
+    std::shared_ptr<AdmissionGate> gate; // concurrency limit of the route's group, if any
     String name;
     std::map<String, String> parameters;
+    std::vector<String> parameterNames; // {placeholder} names in path order
+    RouteMetrics metrics;
 };
 
 struct WebSocketRoute {
@@ -31,17 +69,32 @@ struct WebSocketRoute {
     std::function<void(WebSocketRequest&, uint8_t*, size_t)> onBinary;
     std::vector<String> middleware;
     String name;
+    std::shared_ptr<WebSocketOutbox> outbox;
+    std::shared_ptr<WebSocketAssembler> assembler;
 };
 
 class Router {
 private:
     AsyncWebServer* server;
     std::vector<Route> routes;
+    Route rejectedRoute;    // absorbs registrations made after init(); never matched
+    RouteTrie routeTrie;
+    bool initialized = false;
+    uint32_t unmatchedRequests = 0;
+    portMUX_TYPE metricsLock = portMUX_INITIALIZER_UNLOCKED;
     std::vector<WebSocketRoute> wsRoutes;
     std::map<String, AsyncWebSocket*> webSockets;
     std::map<String, std::shared_ptr<Middleware>> middlewares;
     String prefix;
     std::vector<String> middlewareStack;
+    std::shared_ptr<AdmissionGate> currentGate;
+    WorkerPool workers;
+    uint8_t workerCount = ROUTER_WORKERS;
+    BaseType_t workerCore = ROUTER_WORKER_CORE;
+    uint32_t workerStack = ROUTER_WORKER_STACK;
+    // Deferred requests whose handler finished, waiting for the AsyncTCP task
+    std::vector<std::shared_ptr<DeferredRequest>> completed;
+    SemaphoreHandle_t completedLock;
 
 public:
     Router(AsyncWebServer* webServer);
@@ -54,6 +107,16 @@ public:
     Router& delete_(const String& path, std::function<Response(Request&)> handler);
     Router& any(const String& path, std::function<Response(Request&)> handler);
     
+    // Same, but the handler runs on the worker pool (see defer())
+    Router& getAsync(const String& path, std::function<Response(Request&)> handler);
+    Router& postAsync(const String& path, std::function<Response(Request&)> handler);
+    Router& putAsync(const String& path, std::function<Response(Request&)> handler);
+    Router& patchAsync(const String& path, std::function<Response(Request&)> handler);
+    Router& deleteAsync(const String& path, std::function<Response(Request&)> handler);
+    
+    // Size and placement of the worker pool; takes effect at init()
+    Router& workerPool(uint8_t workers, BaseType_t core = ROUTER_WORKER_CORE, uint32_t stackSize = ROUTER_WORKER_STACK);
+    
     // WebSocket registration
     Router& websocket(const String& path);
     Router& onConnect(std::function<void(WebSocketRequest&)> handler);
@@ -66,8 +129,20 @@ public:
     Router& middleware(const String& name);
     Router& middleware(const std::vector<String>& names);
     
+    // Admission control for the routes of the current group: at most
+    // concurrency requests run at once and up to queue deferred requests wait;
+    // the rest get 503 with Retry-After
+    Router& limit(uint8_t concurrency, uint8_t queue = 0, uint16_t retryAfterSeconds = 5);
+    
+    // Run the last registered route on a worker task, so a slow handler no
+    // longer blocks the AsyncTCP task; the response is sent back on AsyncTCP
+    Router& defer();
+    
     // Named routes
     Router& name(const String& routeName);
+    
+    // Opt the last registered route into streaming body delivery
+    Router& onBody(BodyChunkHandler handler);
     String route(const String& name, const std::map<String, String>& parameters = {});
     
     // Middleware management
@@ -75,22 +150,45 @@ public:
     
     // Route matching and execution
     void handleRequest(AsyncWebServerRequest* request);
+    void handleRequestBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total);
     void handleWebSocketEvent(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len);
     
     // WebSocket utilities
     void broadcastText(const String& path, const String& message);
     void broadcastBinary(const String& path, uint8_t* data, size_t len);
+    // Serializes once and shares the buffer across clients; returns clients reached
+    size_t broadcastJson(const String& path, const JsonDocument& doc);
+    size_t broadcast(const String& path, AsyncWebSocketSharedBuffer buffer, bool binary = false);
+    // Like broadcastJson, but slow clients get the message later through their
+    // outbound queue, coalesced with newer messages on the same topic
+    size_t publish(const String& path, const String& topic, const JsonDocument& doc);
+    size_t publish(const String& path, const String& topic, AsyncWebSocketSharedBuffer buffer, bool binary = false);
     void sendToClient(const String& path, uint32_t clientId, const String& message);
     AsyncWebSocket* getWebSocket(const String& path);
+    WebSocketOutbox* getOutbox(const String& path);
+    
+    // Per-route request metrics
+    void metricsJson(JsonDocument& doc);
+    String metricsPrometheus();
     
     // Initialize routes on server
     void init();
     
 private:
-    Route& addRoute(const String& method, const String& path, std::function<Response(Request&)> handler);
+    Route& addRoute(HttpMethod method, const String& path, std::function<Response(Request&)> handler);
     WebSocketRoute& addWebSocketRoute(const String& path);
-    bool matchRoute(const Route& route, const String& method, const String& path, std::map<String, String>& params);
-    Response executeMiddleware(const std::vector<String>& middleware, Request& request, std::function<Response(Request&)> next);
+    void buildRouteTable();
+    void resolveMiddleware();
+    std::map<String, std::shared_ptr<Middleware>>::iterator configureMiddleware(const String& reference);
+    Route* findRoute(AsyncWebServerRequest* request, RouteMatch& match);
+    void recordMetrics(Route& route, int statusCode, uint32_t elapsedUs);
+    void sendOverloaded(AsyncWebServerRequest* request, Route& route, uint32_t startUs);
+    void handleDeferred(AsyncWebServerRequest* request, Route& route, const RouteMatch& match, uint32_t startUs);
+    void dispatchDeferred(std::shared_ptr<DeferredRequest> job);
+    void runDeferred(std::shared_ptr<DeferredRequest> job);
+    void completeDeferred(std::shared_ptr<DeferredRequest> job);
+    void drainDeferred();
+    RouteMetrics snapshotMetrics(const Route& route);
     WebSocketRoute* currentWsRoute = nullptr; // For chaining WebSocket handlers
 };
 
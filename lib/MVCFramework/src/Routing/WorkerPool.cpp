@@ -0,0 +1,53 @@
+#include "WorkerPool.h"
+#include <SerialDebug.h>
+
+WorkerPool::WorkerPool() : queue(nullptr) {
+}
+
+bool WorkerPool::begin(uint8_t workers, BaseType_t core, uint32_t stackSize, UBaseType_t priority, const char* name) {
+    if (isRunning()) {
+        return true;
+    }
+
+    queue = xQueueCreate(WORKER_POOL_QUEUE_LENGTH, sizeof(std::function<void()>*));
+    if (!queue) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < workers; i++) {
+        TaskHandle_t task = nullptr;
+        String taskName = String(name) + String(i);
+        if (xTaskCreatePinnedToCore(run, taskName.c_str(), stackSize, queue, priority, &task, core) == pdPASS) {
+            tasks.push_back(task);
+        }
+    }
+
+    LOG_INFO("[WorkerPool] %u %s task(s) on core %d", (unsigned)tasks.size(), name, (int)core);
+    return isRunning();
+}
+
+bool WorkerPool::submit(std::function<void()> job) {
+    if (!queue) {
+        return false;
+    }
+
+    std::function<void()>* item = new std::function<void()>(std::move(job));
+    if (xQueueSend(queue, &item, 0) != pdTRUE) {
+        delete item;
+        return false;
+    }
+    return true;
+}
+
+void WorkerPool::run(void* parameter) {
+    QueueHandle_t queue = (QueueHandle_t)parameter;
+
+    for (;;) {
+        std::function<void()>* item = nullptr;
+        if (xQueueReceive(queue, &item, portMAX_DELAY) != pdTRUE || !item) {
+            continue;
+        }
+        (*item)();
+        delete item;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// Jobs waiting for a free worker; submit() fails once this many are pending
+#define WORKER_POOL_QUEUE_LENGTH 16
+
+// FreeRTOS tasks that run deferred work (route handlers, file hashing) off
+// the AsyncTCP task
+class WorkerPool {
+private:
+    QueueHandle_t queue;
+    std::vector<TaskHandle_t> tasks;
+
+    static void run(void* parameter);
+
+public:
+    WorkerPool();
+
+    bool begin(uint8_t workers, BaseType_t core, uint32_t stackSize, UBaseType_t priority, const char* name = "HttpWorker");
+    bool isRunning() const { return !tasks.empty(); }
+
+    // Never blocks; false when the pool is not running or its queue is full
+    bool submit(std::function<void()> job);
+};
+
+#endif
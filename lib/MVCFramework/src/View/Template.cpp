@@ -0,0 +1,611 @@
+#include "Template.h"
+#include "View.h"
+#include <SerialDebug.h>
+#include <esp_heap_caps.h>
+
+static void* allocateTemplateMemory(size_t bytes) {
+    void* memory = nullptr;
+
+    // Compiled templates and fragments are long lived; keep them out of internal RAM
+    if (psramFound()) {
+        memory = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (!memory) {
+        memory = malloc(bytes);
+    }
+    return memory;
+}
+
+static bool isPathChar(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+static bool isNameChar(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static bool startsWith(const char* source, size_t length, size_t pos, const char* prefix) {
+    size_t prefixLength = strlen(prefix);
+    return pos + prefixLength <= length && memcmp(source + pos, prefix, prefixLength) == 0;
+}
+
+static size_t find(const char* source, size_t length, size_t pos, const char* needle) {
+    size_t needleLength = strlen(needle);
+    for (; pos + needleLength <= length; pos++) {
+        if (memcmp(source + pos, needle, needleLength) == 0) {
+            return pos;
+        }
+    }
+    return length;
+}
+
+namespace {
+    // Single pass over the source: emits opcodes and links block directives
+    class TemplateCompiler {
+    private:
+        CompiledTemplate& view;
+        char* source;
+        size_t length;
+        size_t textStart;
+        std::vector<TemplateOp> ops;
+        std::vector<size_t> blocks; // open If/Else/Each opcodes
+
+        void addOp(TemplateOpCode code, uint32_t offset = 0, uint32_t opLength = 0) {
+            TemplateOp op;
+            op.code = code;
+            op.segments = 0;
+            op.negate = false;
+            op.jump = 0;
+            op.offset = offset;
+            op.length = opLength;
+            ops.push_back(op);
+        }
+
+        void flushText(size_t end) {
+            if (end > textStart) {
+                addOp(TemplateOpCode::Text, textStart, end - textStart);
+            }
+        }
+
+        void addDependency(const char* root) {
+            for (const String& dependency : view.dependencies) {
+                if (dependency == root) return;
+            }
+            view.dependencies.push_back(root);
+        }
+
+        // Trims [start, end), NUL-terminates the path segments in place and
+        // stores them on the last opcode
+        bool path(size_t start, size_t end, String& error) {
+            while (start < end && isspace((unsigned char)source[start])) start++;
+            while (end > start && isspace((unsigned char)source[end - 1])) end--;
+
+            if (start == end || source[start] == '.' || source[end - 1] == '.') {
+                error = "Invalid expression at offset " + String((unsigned)start);
+                return false;
+            }
+
+            uint8_t segments = 1;
+            for (size_t i = start; i < end; i++) {
+                if (!isPathChar(source[i])) {
+                    error = "Invalid expression at offset " + String((unsigned)start);
+                    return false;
+                }
+                if (source[i] == '.') {
+                    source[i] = '\0';
+                    segments++;
+                }
+            }
+            source[end] = '\0';
+
+            TemplateOp& op = ops.back();
+            op.offset = start;
+            op.segments = segments;
+            addDependency(source + start);
+            return true;
+        }
+
+        bool variable(size_t& pos, bool raw, String& error) {
+            const char* close = raw ? "!!}" : "}}";
+            size_t open = raw ? 3 : 2;
+            size_t end = find(source, length, pos + open, close);
+            if (end >= length) {
+                error = "Unclosed tag at offset " + String((unsigned)pos);
+                return false;
+            }
+
+            flushText(pos);
+            addOp(raw ? TemplateOpCode::RawVariable : TemplateOpCode::Variable);
+            if (!path(pos + open, end, error)) {
+                return false;
+            }
+
+            pos = end + strlen(close);
+            return true;
+        }
+
+        // Arguments between "(" and ")" directly after a directive name
+        bool arguments(size_t& pos, size_t& start, size_t& end, String& error) {
+            if (pos >= length || source[pos] != '(') {
+                error = "Expected ( at offset " + String((unsigned)pos);
+                return false;
+            }
+            start = pos + 1;
+            end = find(source, length, start, ")");
+            if (end >= length) {
+                error = "Unclosed ( at offset " + String((unsigned)pos);
+                return false;
+            }
+            pos = end + 1;
+            return true;
+        }
+
+        bool closeBlock(TemplateOpCode expected, TemplateOpCode alternative, const char* directive, String& error) {
+            if (blocks.empty() || (ops[blocks.back()].code != expected && ops[blocks.back()].code != alternative)) {
+                error = String("Unexpected @") + directive;
+                return false;
+            }
+            ops[blocks.back()].jump = ops.size();
+            blocks.pop_back();
+            return true;
+        }
+
+        // Returns false with an empty error when '@' does not start a directive
+        bool directive(size_t& pos, String& error) {
+            size_t nameEnd = pos + 1;
+            while (nameEnd < length && isalpha((unsigned char)source[nameEnd])) nameEnd++;
+
+            String name;
+            name.concat(source + pos + 1, nameEnd - pos - 1);
+
+            size_t start = 0;
+            size_t end = 0;
+            size_t directiveStart = pos;
+            pos = nameEnd;
+
+            if (name == "if") {
+                if (!arguments(pos, start, end, error)) return false;
+                flushText(directiveStart);
+                blocks.push_back(ops.size());
+                addOp(TemplateOpCode::If);
+
+                while (start < end && isspace((unsigned char)source[start])) start++;
+                bool negate = start < end && source[start] == '!';
+                if (negate) start++;
+                if (!path(start, end, error)) return false;
+                ops.back().negate = negate;
+            } else if (name == "else") {
+                if (blocks.empty() || ops[blocks.back()].code != TemplateOpCode::If) {
+                    error = "Unexpected @else";
+                    return false;
+                }
+                flushText(directiveStart);
+                ops[blocks.back()].jump = ops.size();
+                blocks.back() = ops.size();
+                addOp(TemplateOpCode::Else);
+            } else if (name == "endif") {
+                flushText(directiveStart);
+                if (!closeBlock(TemplateOpCode::If, TemplateOpCode::Else, "endif", error)) return false;
+                addOp(TemplateOpCode::EndIf);
+            } else if (name == "foreach") {
+                if (!arguments(pos, start, end, error)) return false;
+                flushText(directiveStart);
+
+                size_t separator = find(source, end, start, " as ");
+                if (separator >= end) {
+                    error = "Expected @foreach(items as item) at offset " + String((unsigned)directiveStart);
+                    return false;
+                }
+
+                size_t alias = separator + 4;
+                while (alias < end && isspace((unsigned char)source[alias])) alias++;
+                size_t aliasEnd = alias;
+                while (aliasEnd < end && isNameChar(source[aliasEnd])) aliasEnd++;
+                if (aliasEnd == alias) {
+                    error = "Missing loop variable at offset " + String((unsigned)directiveStart);
+                    return false;
+                }
+                source[aliasEnd] = '\0';
+
+                blocks.push_back(ops.size());
+                addOp(TemplateOpCode::Each);
+                if (!path(start, separator, error)) return false;
+                ops.back().length = alias;
+            } else if (name == "endforeach") {
+                flushText(directiveStart);
+                size_t each = blocks.empty() ? 0 : blocks.back();
+                if (!closeBlock(TemplateOpCode::Each, TemplateOpCode::Each, "endforeach", error)) return false;
+                addOp(TemplateOpCode::EndEach);
+                ops.back().jump = each;
+            } else if (name == "include") {
+                if (!arguments(pos, start, end, error)) return false;
+                while (start < end && isspace((unsigned char)source[start])) start++;
+                while (end > start && isspace((unsigned char)source[end - 1])) end--;
+
+                char quote = start < end ? source[start] : 0;
+                if ((quote != '\'' && quote != '"') || end - start < 3 || source[end - 1] != quote) {
+                    error = "Expected @include('name') at offset " + String((unsigned)directiveStart);
+                    return false;
+                }
+                flushText(directiveStart);
+                source[end - 1] = '\0';
+                addOp(TemplateOpCode::Include, start + 1);
+                view.includes.push_back(source + start + 1);
+            } else {
+                // Not a directive, e.g. an e-mail address or a CSS at-rule
+                pos = directiveStart + 1;
+                return false;
+            }
+
+            return true;
+        }
+
+    public:
+        TemplateCompiler(CompiledTemplate& view, char* source, size_t length)
+            : view(view), source(source), length(length), textStart(0) {}
+
+        bool run(String& error) {
+            size_t pos = 0;
+
+            while (pos < length) {
+                if (startsWith(source, length, pos, "{{")) {
+                    if (!variable(pos, false, error)) return false;
+                    textStart = pos;
+                } else if (startsWith(source, length, pos, "{!!")) {
+                    if (!variable(pos, true, error)) return false;
+                    textStart = pos;
+                } else if (source[pos] == '@') {
+                    if (directive(pos, error)) {
+                        textStart = pos;
+                    } else if (error.length() > 0) {
+                        return false;
+                    }
+                } else {
+                    pos++;
+                }
+            }
+            flushText(length);
+
+            if (!blocks.empty()) {
+                error = ops[blocks.back()].code == TemplateOpCode::Each ? "Missing @endforeach" : "Missing @endif";
+                return false;
+            }
+            if (ops.size() > 0xFFFF) {
+                error = "Template too large";
+                return false;
+            }
+            return true;
+        }
+
+        const std::vector<TemplateOp>& result() const { return ops; }
+    };
+
+    // FNV-1a over everything serializeJson() writes
+    class FragmentHasher {
+    private:
+        uint64_t& hash;
+
+    public:
+        FragmentHasher(uint64_t& hash) : hash(hash) {}
+
+        size_t write(uint8_t c) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+            return 1;
+        }
+
+        size_t write(const uint8_t* data, size_t length) {
+            for (size_t i = 0; i < length; i++) {
+                write(data[i]);
+            }
+            return length;
+        }
+    };
+}
+
+CompiledTemplate::CompiledTemplate() : source(nullptr), ops(nullptr), opCount(0), version(0) {
+}
+
+CompiledTemplate::~CompiledTemplate() {
+    free(source);
+    free(ops);
+}
+
+std::shared_ptr<CompiledTemplate> CompiledTemplate::compile(const String& name, File& file, String& error) {
+    std::shared_ptr<CompiledTemplate> view = std::make_shared<CompiledTemplate>();
+    view->name = name;
+
+    size_t length = file.size();
+    view->source = (char*)allocateTemplateMemory(length + 1);
+    if (!view->source) {
+        error = "Out of memory loading " + name;
+        return nullptr;
+    }
+    length = file.read((uint8_t*)view->source, length);
+    view->source[length] = '\0';
+
+    TemplateCompiler compiler(*view, view->source, length);
+    if (!compiler.run(error)) {
+        error = name + ": " + error;
+        return nullptr;
+    }
+
+    const std::vector<TemplateOp>& ops = compiler.result();
+    if (!ops.empty()) {
+        view->ops = (TemplateOp*)allocateTemplateMemory(ops.size() * sizeof(TemplateOp));
+        if (!view->ops) {
+            error = "Out of memory compiling " + name;
+            return nullptr;
+        }
+        memcpy(view->ops, ops.data(), ops.size() * sizeof(TemplateOp));
+    }
+    view->opCount = ops.size();
+
+    return view;
+}
+
+TemplateFragment::~TemplateFragment() {
+    free(data);
+}
+
+TemplateRenderer::TemplateRenderer(std::shared_ptr<const CompiledTemplate> view, std::shared_ptr<const JsonDocument> data)
+    : data(data), pending(nullptr), pendingLength(0) {
+    frames.push_back(Frame{view, 0, false, 0, String()});
+}
+
+size_t TemplateRenderer::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen) {
+        if (pendingLength == 0 && !advance()) {
+            break;
+        }
+
+        size_t chunk = pendingLength < maxLen - written ? pendingLength : maxLen - written;
+        memcpy(buffer + written, pending, chunk);
+        pending += chunk;
+        pendingLength -= chunk;
+        written += chunk;
+    }
+
+    return written;
+}
+
+// Runs opcodes until one produces output; false once every frame is done
+bool TemplateRenderer::advance() {
+    while (!frames.empty()) {
+        Frame& frame = frames.back();
+        const CompiledTemplate& view = *frame.view;
+
+        if (frame.pc >= view.size()) {
+            finishFrame();
+            continue;
+        }
+
+        const TemplateOp& op = view.op(frame.pc);
+        switch (op.code) {
+            case TemplateOpCode::Text:
+                frame.pc++;
+                emit(view.text(op.offset), op.length);
+                return true;
+
+            case TemplateOpCode::Variable:
+            case TemplateOpCode::RawVariable:
+                frame.pc++;
+                emitValue(resolve(view, op), op.code == TemplateOpCode::Variable);
+                if (pendingLength > 0) {
+                    return true;
+                }
+                break;
+
+            case TemplateOpCode::If: {
+                JsonVariantConst value = resolve(view, op);
+                bool truthy;
+                if (value.isNull()) {
+                    truthy = false;
+                } else if (value.is<bool>()) {
+                    truthy = value.as<bool>();
+                } else if (value.is<const char*>()) {
+                    truthy = value.as<const char*>()[0] != '\0';
+                } else if (value.is<JsonArrayConst>() || value.is<JsonObjectConst>()) {
+                    truthy = value.size() > 0;
+                } else {
+                    truthy = value.as<double>() != 0;
+                }
+                frame.pc = truthy != op.negate ? frame.pc + 1 : op.jump + 1;
+                break;
+            }
+
+            case TemplateOpCode::Else:
+                // Reached the end of the taken @if branch
+                frame.pc = op.jump + 1;
+                break;
+
+            case TemplateOpCode::EndIf:
+                frame.pc++;
+                break;
+
+            case TemplateOpCode::Each: {
+                JsonArrayConst items = resolve(view, op).as<JsonArrayConst>();
+                if (items.isNull() || items.begin() == items.end()) {
+                    frame.pc = op.jump + 1;
+                    break;
+                }
+                loops.push_back(Loop{items.begin(), items.end(), frame.pc + 1});
+                scope.push_back(Binding{view.text(op.length), *loops.back().current});
+                frame.pc++;
+                break;
+            }
+
+            case TemplateOpCode::EndEach: {
+                Loop& loop = loops.back();
+                ++loop.current;
+                if (loop.current != loop.end) {
+                    scope.back().value = *loop.current;
+                    frame.pc = loop.body;
+                } else {
+                    loops.pop_back();
+                    scope.pop_back();
+                    frame.pc++;
+                }
+                break;
+            }
+
+            case TemplateOpCode::Include:
+                frame.pc++;
+                // May push a frame, which invalidates `frame`
+                if (include(view.text(op.offset))) {
+                    return true;
+                }
+                break;
+        }
+    }
+
+    return false;
+}
+
+void TemplateRenderer::emit(const char* text, size_t length) {
+    pending = text;
+    pendingLength = length;
+
+    for (Frame& frame : frames) {
+        if (!frame.capturing) continue;
+
+        if (frame.capture.length() + length > TEMPLATE_FRAGMENT_MAX_SIZE) {
+            // Too large to cache; stop recording
+            frame.capturing = false;
+            frame.capture = String();
+        } else {
+            frame.capture.concat(text, length);
+        }
+    }
+}
+
+void TemplateRenderer::emitValue(JsonVariantConst value, bool escape) {
+    if (value.isNull()) {
+        pendingLength = 0;
+        return;
+    }
+
+    // Strings are emitted straight from the document, which outlives the renderer's output
+    const char* text;
+    if (value.is<const char*>()) {
+        text = value.as<const char*>();
+    } else {
+        scratch = "";
+        serializeJson(value, scratch);
+        text = scratch.c_str();
+    }
+
+    if (!escape || !strpbrk(text, "&<>\"'")) {
+        emit(text, strlen(text));
+        return;
+    }
+
+    String escaped;
+    escaped.reserve(strlen(text) + 16);
+    for (const char* c = text; *c; c++) {
+        switch (*c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            case '\'': escaped += "&#39;"; break;
+            default: escaped += *c; break;
+        }
+    }
+    scratch = escaped;
+    emit(scratch.c_str(), scratch.length());
+}
+
+// Emits a cached fragment (true) or pushes a frame that renders and records the partial
+bool TemplateRenderer::include(const char* name) {
+    if (frames.size() >= TEMPLATE_MAX_DEPTH) {
+        LOG_WARNING("[View] Include depth exceeded at '%s'", name);
+        return false;
+    }
+
+    TemplateEngine* engine = TemplateEngine::getInstance();
+    String error;
+    std::shared_ptr<const CompiledTemplate> partial = engine->compiled(name, error);
+    if (!partial) {
+        LOG_ERROR("[View] %s", error.c_str());
+        return false;
+    }
+
+    uint64_t key = 0xcbf29ce484222325ULL;
+    hashDependencies(*partial, key, frames.size());
+
+    std::shared_ptr<const TemplateFragment> cached = engine->fragment(partial->name, key);
+    if (cached) {
+        pendingFragment = cached;
+        emit(cached->data, cached->length);
+        return cached->length > 0;
+    }
+
+    frames.push_back(Frame{partial, 0, true, key, String()});
+    return false;
+}
+
+void TemplateRenderer::finishFrame() {
+    Frame& frame = frames.back();
+    if (frame.capturing) {
+        TemplateEngine::getInstance()->storeFragment(frame.view->name, frame.fragmentKey, frame.capture);
+    }
+    frames.pop_back();
+}
+
+JsonVariantConst TemplateRenderer::lookup(const char* root) const {
+    for (auto it = scope.rbegin(); it != scope.rend(); ++it) {
+        if (strcmp(it->name, root) == 0) {
+            return it->value;
+        }
+    }
+
+    JsonVariantConst value = (*data)[root];
+    if (value.isNull()) {
+        value = TemplateEngine::getInstance()->global(root);
+    }
+    return value;
+}
+
+JsonVariantConst TemplateRenderer::resolve(const CompiledTemplate& view, const TemplateOp& op) const {
+    const char* segment = view.text(op.offset);
+    JsonVariantConst value = lookup(segment);
+
+    for (uint8_t i = 1; i < op.segments && !value.isNull(); i++) {
+        segment += strlen(segment) + 1;
+        if (isdigit((unsigned char)segment[0]) && value.is<JsonArrayConst>()) {
+            value = value[(size_t)atoi(segment)];
+        } else {
+            value = value[segment];
+        }
+    }
+    return value;
+}
+
+// Fragment key: the partial's identity plus every value it (or a nested
+// partial) can read, so a cached fragment is reused only when unchanged
+void TemplateRenderer::hashDependencies(const CompiledTemplate& view, uint64_t& hash, size_t depth) const {
+    FragmentHasher hasher(hash);
+    hasher.write((const uint8_t*)view.name.c_str(), view.name.length() + 1);
+    hasher.write((const uint8_t*)&view.version, sizeof(view.version));
+
+    for (const String& dependency : view.dependencies) {
+        hasher.write((const uint8_t*)dependency.c_str(), dependency.length() + 1);
+        serializeJson(lookup(dependency.c_str()), hasher);
+    }
+
+    if (depth + 1 >= TEMPLATE_MAX_DEPTH) {
+        return;
+    }
+
+    TemplateEngine* engine = TemplateEngine::getInstance();
+    for (const String& name : view.includes) {
+        String error;
+        std::shared_ptr<const CompiledTemplate> partial = engine->compiled(name, error);
+        if (partial) {
+            hashDependencies(*partial, hash, depth + 1);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <memory>
+#include <vector>
+
+// Include nesting limit; also stops a partial from including itself forever
+#define TEMPLATE_MAX_DEPTH 8
+// Rendered partials larger than this are not kept in the fragment cache
+#define TEMPLATE_FRAGMENT_MAX_SIZE 4096
+// Total bytes the fragment cache may hold
+#define TEMPLATE_FRAGMENT_CACHE_SIZE (32 * 1024)
+
+// Template syntax:
+//   {{ user.name }}                  HTML-escaped value
+//   {!! page.html !!}                raw value
+//   @if(user.admin) ... @else ... @endif    (@if(!path) negates)
+//   @foreach(devices as device) ... @endforeach
+//   @include('partials.nav')         /views/partials/nav.html
+enum class TemplateOpCode : uint8_t {
+    Text,
+    Variable,
+    RawVariable,
+    If,
+    Else,
+    EndIf,
+    Each,
+    EndEach,
+    Include
+};
+
+struct TemplateOp {
+    TemplateOpCode code;
+    uint8_t segments;  // Variable/If/Each: number of path segments at offset
+    bool negate;       // If: condition is inverted
+    uint16_t jump;     // If/Else/Each: matching Else/EndIf/EndEach; EndEach: matching Each
+    uint32_t offset;   // Text: span start; otherwise the NUL-terminated path or include name
+    uint32_t length;   // Text: span length; Each: offset of the loop variable name
+};
+
+// A template compiled once from /views. The source and the opcode list are
+// kept in PSRAM when available. Text opcodes point into the source, and tag
+// arguments are NUL-terminated in place, so rendering copies nothing.
+class CompiledTemplate {
+private:
+    char* source;
+    TemplateOp* ops;
+    size_t opCount;
+
+public:
+    String name;
+    uint32_t version;
+    std::vector<String> dependencies; // root names read by this template
+    std::vector<String> includes;     // partials included by this template
+
+    CompiledTemplate();
+    ~CompiledTemplate();
+    CompiledTemplate(const CompiledTemplate&) = delete;
+    CompiledTemplate& operator=(const CompiledTemplate&) = delete;
+
+    static std::shared_ptr<CompiledTemplate> compile(const String& name, File& file, String& error);
+
+    const char* text(uint32_t offset) const { return source + offset; }
+    const TemplateOp& op(size_t index) const { return ops[index]; }
+    size_t size() const { return opCount; }
+};
+
+// A rendered partial, reused while the values it depends on are unchanged
+struct TemplateFragment {
+    uint64_t key;
+    char* data;
+    size_t length;
+
+    TemplateFragment() : key(0), data(nullptr), length(0) {}
+    ~TemplateFragment();
+};
+
+// Resumable renderer: each read() call produces the next slice of the page,
+// so a response filler can stream it without building the page in memory.
+class TemplateRenderer {
+private:
+    struct Frame {
+        std::shared_ptr<const CompiledTemplate> view;
+        size_t pc;
+        bool capturing;      // output is recorded for the fragment cache
+        uint64_t fragmentKey;
+        String capture;
+    };
+
+    struct Loop {
+        JsonArrayConst::iterator current;
+        JsonArrayConst::iterator end;
+        size_t body;
+    };
+
+    struct Binding {
+        const char* name;
+        JsonVariantConst value;
+    };
+
+    std::shared_ptr<const JsonDocument> data;
+    std::vector<Frame> frames;
+    std::vector<Loop> loops;
+    std::vector<Binding> scope;
+
+    const char* pending;
+    size_t pendingLength;
+    String scratch;
+    std::shared_ptr<const TemplateFragment> pendingFragment;
+
+    bool advance();
+    void emit(const char* text, size_t length);
+    void emitValue(JsonVariantConst value, bool escape);
+    bool include(const char* name);
+    void finishFrame();
+
+    JsonVariantConst lookup(const char* root) const;
+    JsonVariantConst resolve(const CompiledTemplate& view, const TemplateOp& op) const;
+    void hashDependencies(const CompiledTemplate& view, uint64_t& hash, size_t depth) const;
+
+public:
+    TemplateRenderer(std::shared_ptr<const CompiledTemplate> view, std::shared_ptr<const JsonDocument> data);
+
+    // Writes up to maxLen bytes of output; returns 0 once the page is complete
+    size_t read(uint8_t* buffer, size_t maxLen);
+};
+
+#endif
@@ -0,0 +1,224 @@
+#include "View.h"
+#include "../Core/Application.h"
+#include "../Routing/Router.h"
+#include <SerialDebug.h>
+#include <SPIFFS.h>
+#include <esp_heap_caps.h>
+
+// View implementation
+View::View(const String& path) : templatePath(path) {
+}
+
+View& View::with(const String& key, const String& value) {
+    data[key] = value;
+    return *this;
+}
+
+View& View::with(const String& key, int value) {
+    data[key] = value;
+    return *this;
+}
+
+View& View::with(const String& key, bool value) {
+    data[key] = value;
+    return *this;
+}
+
+View& View::with(const JsonDocument& values) {
+    for (JsonPairConst pair : values.as<JsonObjectConst>()) {
+        data[pair.key()] = pair.value();
+    }
+    return *this;
+}
+
+View& View::withErrors(const std::vector<String>& errors) {
+    JsonArray list = data["errors"].to<JsonArray>();
+    for (const String& error : errors) {
+        list.add(error);
+    }
+    return *this;
+}
+
+String View::render() {
+    return TemplateEngine::getInstance()->render(templatePath, data);
+}
+
+String View::asset(const String& path) {
+    return path.startsWith("/") ? "/assets" + path : "/assets/" + path;
+}
+
+String View::route(const String& name, const std::map<String, String>& parameters) {
+    Application* app = Application::getInstance();
+    if (!app || !app->getRouter()) {
+        return "";
+    }
+    return app->getRouter()->route(name, parameters);
+}
+
+String View::url(const String& path) {
+    return path.startsWith("/") ? path : "/" + path;
+}
+
+// TemplateEngine implementation
+TemplateEngine* TemplateEngine::instance = nullptr;
+
+TemplateEngine::TemplateEngine()
+    : viewsPath("/views"), fragmentBytes(0), nextVersion(1), lock(xSemaphoreCreateMutex()) {
+}
+
+TemplateEngine* TemplateEngine::getInstance() {
+    if (instance == nullptr) {
+        instance = new TemplateEngine();
+    }
+    return instance;
+}
+
+void TemplateEngine::setViewsPath(const String& path) {
+    viewsPath = path;
+    clearCache();
+}
+
+void TemplateEngine::addGlobal(const String& key, const String& value) {
+    globals[key] = value;
+}
+
+String TemplateEngine::getGlobal(const String& key, const String& defaultValue) const {
+    JsonVariantConst value = globals[key];
+    return value.isNull() ? defaultValue : value.as<String>();
+}
+
+// "partials.nav" -> /views/partials/nav.html
+String TemplateEngine::templateFile(const String& template_name) const {
+    String name = template_name;
+    if (name.endsWith(".html")) {
+        name = name.substring(0, name.length() - 5);
+    }
+    name.replace('.', '/');
+    return viewsPath + "/" + name + ".html";
+}
+
+std::shared_ptr<const CompiledTemplate> TemplateEngine::compiled(const String& template_name, String& error) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = templates.find(template_name);
+    if (it != templates.end()) {
+        std::shared_ptr<const CompiledTemplate> view = it->second;
+        xSemaphoreGive(lock);
+        return view;
+    }
+    xSemaphoreGive(lock);
+
+    // Compile outside the lock; a concurrent compile of the same view just loses the race
+    String path = templateFile(template_name);
+    File file = SPIFFS.open(path, "r");
+    if (!file) {
+        error = "Template not found: " + path;
+        return nullptr;
+    }
+
+    std::shared_ptr<CompiledTemplate> view = CompiledTemplate::compile(template_name, file, error);
+    file.close();
+    if (!view) {
+        return nullptr;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto existing = templates.find(template_name);
+    if (existing != templates.end()) {
+        view = existing->second;
+    } else {
+        view->version = nextVersion++;
+        templates[template_name] = view;
+    }
+    xSemaphoreGive(lock);
+
+    return view;
+}
+
+std::shared_ptr<TemplateRenderer> TemplateEngine::renderer(const String& template_name, const JsonDocument& data, String& error) {
+    std::shared_ptr<const CompiledTemplate> view = compiled(template_name, error);
+    if (!view) {
+        return nullptr;
+    }
+    return std::make_shared<TemplateRenderer>(view, std::make_shared<JsonDocument>(data));
+}
+
+String TemplateEngine::render(const String& template_name, const JsonDocument& data) {
+    String error;
+    std::shared_ptr<TemplateRenderer> renderer = this->renderer(template_name, data, error);
+    if (!renderer) {
+        LOG_ERROR("[View] %s", error.c_str());
+        return "";
+    }
+
+    String output;
+    uint8_t buffer[256];
+    size_t length;
+    while ((length = renderer->read(buffer, sizeof(buffer))) > 0) {
+        output.concat((const char*)buffer, length);
+    }
+    return output;
+}
+
+std::shared_ptr<const TemplateFragment> TemplateEngine::fragment(const String& template_name, uint64_t key) {
+    std::shared_ptr<const TemplateFragment> cached;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = fragments.find(template_name);
+    if (it != fragments.end() && it->second->key == key) {
+        cached = it->second;
+    }
+    xSemaphoreGive(lock);
+
+    return cached;
+}
+
+void TemplateEngine::storeFragment(const String& template_name, uint64_t key, const String& content) {
+    std::shared_ptr<TemplateFragment> entry = std::make_shared<TemplateFragment>();
+    entry->key = key;
+    entry->length = content.length();
+
+    if (entry->length > 0) {
+        if (psramFound()) {
+            entry->data = (char*)heap_caps_malloc(entry->length, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!entry->data) {
+            entry->data = (char*)malloc(entry->length);
+        }
+        if (!entry->data) {
+            return;
+        }
+        memcpy(entry->data, content.c_str(), entry->length);
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // One entry per partial: the latest rendering replaces the previous one
+    auto it = fragments.find(template_name);
+    if (it != fragments.end()) {
+        fragmentBytes -= it->second->length;
+        fragments.erase(it);
+    }
+    if (fragmentBytes + entry->length <= TEMPLATE_FRAGMENT_CACHE_SIZE) {
+        fragments[template_name] = entry;
+        fragmentBytes += entry->length;
+    }
+    xSemaphoreGive(lock);
+}
+
+void TemplateEngine::clearCache() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    templates.clear();
+    fragments.clear();
+    fragmentBytes = 0;
+    xSemaphoreGive(lock);
+}
+
+// Helper functions
+View view(const String& template_name, const JsonDocument& data) {
+    View result(template_name);
+    result.with(data);
+    return result;
+}
+
+String renderView(const String& template_name, const JsonDocument& data) {
+    return TemplateEngine::getInstance()->render(template_name, data);
+}
@@ -4,62 +4,77 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <map>
+#include <memory>
+#include <vector>
+#include "Template.h"
 
 class View {
 private:
     String templatePath;
     JsonDocument data;
-    String compiledContent;
 
 public:
     View(const String& path);
-    
+
     // Data binding
     View& with(const String& key, const String& value);
     View& with(const String& key, int value);
     View& with(const String& key, bool value);
     View& with(const JsonDocument& data);
     View& withErrors(const std::vector<String>& errors);
-    
-    // Template compilation
+
+    // Render the whole page into a String; Response::view() streams instead
     String render();
-    String compile();
-    
+
+    const String& getTemplate() const { return templatePath; }
+    const JsonDocument& getData() const { return data; }
+
     // Template helpers
     static String asset(const String& path);
     static String route(const String& name, const std::map<String, String>& parameters = {});
     static String url(const String& path);
-    
-private:
-    String loadTemplate(const String& path);
-    String parseTemplate(const String& content);
-    String replaceVariables(const String& content);
-    String processDirectives(const String& content);
-    String processIncludes(const String& content);
-    String processLoops(const String& content);
-    String processConditions(const String& content);
 };
 
-// Template engine for simple templating
+// Template engine: compiles each template once and caches rendered partials
 class TemplateEngine {
 private:
     static TemplateEngine* instance;
-    std::map<String, String> globals;
+    JsonDocument globals;
     String viewsPath;
 
+    std::map<String, std::shared_ptr<CompiledTemplate>> templates;
+    std::map<String, std::shared_ptr<TemplateFragment>> fragments;
+    size_t fragmentBytes;
+    uint32_t nextVersion;
+    SemaphoreHandle_t lock;
+
+    String templateFile(const String& template_name) const;
+
 public:
     static TemplateEngine* getInstance();
-    
-    void setViewsPath(const String& path) { viewsPath = path; }
+
+    void setViewsPath(const String& path);
     String getViewsPath() const { return viewsPath; }
-    
+
     void addGlobal(const String& key, const String& value);
     String getGlobal(const String& key, const String& defaultValue = "") const;
-    
+    JsonVariantConst global(const char* key) const { return globals[key]; }
+
     String render(const String& template_name, const JsonDocument& data = JsonDocument());
-    
+
+    // Compiled template, compiling it on first use; nullptr with error set on failure
+    std::shared_ptr<const CompiledTemplate> compiled(const String& template_name, String& error);
+    std::shared_ptr<TemplateRenderer> renderer(const String& template_name, const JsonDocument& data, String& error);
+
+    // Fragment cache for included partials
+    std::shared_ptr<const TemplateFragment> fragment(const String& template_name, uint64_t key);
+    void storeFragment(const String& template_name, uint64_t key, const String& content);
+
+    // Drop compiled templates and fragments, e.g. after new views were uploaded
+    void clearCache();
+
 private:
-    TemplateEngine() : viewsPath("/views") {}
+    TemplateEngine();
 };
 
 // Helper functions for view creation
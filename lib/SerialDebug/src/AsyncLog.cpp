@@ -0,0 +1,316 @@
+#include "AsyncLog.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/ringbuf.h>
+#include <freertos/task.h>
+
+namespace AsyncLog {
+
+// Record layout: level, argument count, format pointer, then per argument a
+// type byte followed by 8 value bytes, or a length byte and the string bytes.
+struct RecordHeader {
+    uint8_t level;
+    uint8_t argc;
+    const char* format;
+};
+
+static RingbufHandle_t buffer = nullptr;
+static TaskHandle_t drainTask = nullptr;
+static std::atomic<uint32_t> droppedRecords(0);
+
+static const char* const levelPrefixes[] = {
+    "[ERROR] ", "[WARNING] ", "[INFO] ", "[DEBUG] ", "[VERBOSE] "
+};
+
+// Bytes a %s argument keeps when each string may use up to cap bytes
+static size_t storedLength(const Arg& arg, size_t cap, bool& truncated) {
+    size_t length = arg.s ? strnlen(arg.s, cap + 1) : 0;
+    truncated = length > cap;
+    return truncated ? cap : length;
+}
+
+static size_t stringBytes(std::initializer_list<Arg> args, uint8_t argc, size_t cap) {
+    size_t total = 0;
+    const Arg* arg = args.begin();
+    for (uint8_t n = 0; n < argc; n++, arg++) {
+        if (arg->type == ArgString) {
+            bool truncated;
+            total += storedLength(*arg, cap, truncated);
+        }
+    }
+    return total;
+}
+
+// Fixed parts first (type byte plus value or length byte), so a long string
+// never pushes later arguments out. Strings then share what is left: cap is
+// the largest per-string length that fits, so short strings stay whole and
+// only the long ones are cut.
+static size_t recordSize(std::initializer_list<Arg> args, uint8_t& argc, size_t& cap) {
+    size_t size = sizeof(RecordHeader);
+    argc = 0;
+    for (const Arg& arg : args) {
+        size_t fixed = arg.type == ArgString ? 2 : 1 + 8;
+        if (size + fixed > ASYNC_LOG_MAX_RECORD || argc == 255) {
+            break;
+        }
+        size += fixed;
+        argc++;
+    }
+    size_t budget = ASYNC_LOG_MAX_RECORD - size;
+
+    cap = 255; // the length byte's range
+    size_t strings = stringBytes(args, argc, cap);
+    if (strings > budget) {
+        size_t low = 0;
+        size_t high = cap;
+        while (low < high) {
+            size_t mid = (low + high + 1) / 2;
+            if (stringBytes(args, argc, mid) <= budget) {
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+        cap = low;
+        strings = stringBytes(args, argc, cap);
+    }
+    return size + strings;
+}
+
+static void encode(uint8_t* out, uint8_t level, const char* format, std::initializer_list<Arg> args, uint8_t argc, size_t cap) {
+    RecordHeader header = { level, argc, format };
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    const Arg* arg = args.begin();
+    for (uint8_t n = 0; n < argc; n++, arg++) {
+        *out++ = arg->type;
+        if (arg->type == ArgString) {
+            bool truncated;
+            size_t length = storedLength(*arg, cap, truncated);
+            *out++ = length;
+            if (truncated) {
+                // Keep the head and end it with a visible marker
+                size_t marker = strlen(ASYNC_LOG_TRUNCATED);
+                size_t kept = length > marker ? length - marker : 0;
+                memcpy(out, arg->s, kept);
+                memcpy(out + kept, ASYNC_LOG_TRUNCATED, length - kept);
+            } else {
+                memcpy(out, arg->s, length);
+            }
+            out += length;
+        } else {
+            memcpy(out, &arg->u, 8);
+            out += 8;
+        }
+    }
+}
+
+// Reads the next encoded argument; returns false when the record has none left
+static bool nextArg(const uint8_t*& cursor, const uint8_t* end, uint8_t& type, uint64_t& value, char* text) {
+    if (cursor >= end) {
+        return false;
+    }
+    type = *cursor++;
+    if (type == ArgString) {
+        uint8_t length = *cursor++;
+        memcpy(text, cursor, length);
+        text[length] = '\0';
+        cursor += length;
+    } else {
+        memcpy(&value, cursor, 8);
+        cursor += 8;
+    }
+    return true;
+}
+
+// Formats one record by walking its format string and passing each
+// conversion to snprintf with the argument widened to its stored type
+static size_t render(const uint8_t* record, size_t size, char* out, size_t capacity) {
+    RecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    const uint8_t* cursor = record + sizeof(header);
+    const uint8_t* end = record + size;
+
+    size_t length = 0;
+    auto append = [&](const char* text, size_t count) {
+        if (count > capacity - 1 - length) {
+            count = capacity - 1 - length;
+        }
+        memcpy(out + length, text, count);
+        length += count;
+    };
+
+    if (header.level < sizeof(levelPrefixes) / sizeof(levelPrefixes[0])) {
+        append(levelPrefixes[header.level], strlen(levelPrefixes[header.level]));
+    }
+
+    char text[256];
+    char spec[24];
+    char piece[256];
+    const char* p = header.format;
+
+    while (*p) {
+        if (*p != '%') {
+            const char* start = p;
+            while (*p && *p != '%') p++;
+            append(start, p - start);
+            continue;
+        }
+        if (p[1] == '%') {
+            append("%", 1);
+            p += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion
+        size_t specLength = 0;
+        spec[specLength++] = *p++;
+        bool missing = false;
+        while (*p && strchr("-+ #0123456789.*hlLqjzt", *p)) {
+            char c = *p++;
+            if (strchr("hlLqjzt", c)) {
+                continue; // the stored value is already 64-bit
+            }
+            if (c == '*') {
+                uint8_t type;
+                uint64_t value = 0;
+                if (!nextArg(cursor, end, type, value, text)) {
+                    missing = true;
+                }
+                if (specLength < sizeof(spec) - 16) {
+                    specLength += snprintf(spec + specLength, 12, "%d", (int)(int64_t)value);
+                }
+            } else if (specLength < sizeof(spec) - 4) {
+                spec[specLength++] = c;
+            }
+        }
+        char conversion = *p;
+        if (!conversion) {
+            break;
+        }
+        p++;
+
+        uint8_t type = ArgSigned;
+        uint64_t value = 0;
+        if (missing || !nextArg(cursor, end, type, value, text)) {
+            append("<?>", 3);
+            continue;
+        }
+
+        int written = 0;
+        switch (conversion) {
+            case 'd': case 'i':
+            case 'u': case 'o': case 'x': case 'X':
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                if (type == ArgDouble) {
+                    double d;
+                    memcpy(&d, &value, 8);
+                    value = (uint64_t)(int64_t)d;
+                }
+                written = snprintf(piece, sizeof(piece), spec, (unsigned long long)value);
+                break;
+            case 'c':
+                spec[specLength++] = 'c';
+                spec[specLength] = '\0';
+                written = snprintf(piece, sizeof(piece), spec, (int)value);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+                double d;
+                if (type == ArgDouble) {
+                    memcpy(&d, &value, 8);
+                } else {
+                    d = type == ArgSigned ? (double)(int64_t)value : (double)value;
+                }
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(piece, sizeof(piece), spec, d);
+                break;
+            }
+            case 's':
+                spec[specLength++] = 's';
+                spec[specLength] = '\0';
+                written = snprintf(piece, sizeof(piece), spec, type == ArgString ? text : "<?>");
+                break;
+            case 'p':
+                written = snprintf(piece, sizeof(piece), "%p", (void*)(uintptr_t)value);
+                break;
+            default:
+                break;
+        }
+        if (written > 0) {
+            append(piece, written < (int)sizeof(piece) ? written : sizeof(piece) - 1);
+        }
+    }
+
+    out[length++] = '\n';
+    return length;
+}
+
+static void print(const uint8_t* record, size_t size) {
+    char line[256];
+    size_t length = render(record, size, line, sizeof(line) - 1);
+    Serial.write((const uint8_t*)line, length);
+}
+
+static void drain(void* parameter) {
+    for (;;) {
+        size_t size = 0;
+        uint8_t* record = (uint8_t*)xRingbufferReceive(buffer, &size, portMAX_DELAY);
+        if (!record) {
+            continue;
+        }
+        print(record, size);
+        vRingbufferReturnItem(buffer, record);
+
+        uint32_t lost = droppedRecords.exchange(0);
+        if (lost > 0) {
+            Serial.printf("[LOG] %u messages dropped\n", (unsigned)lost);
+        }
+    }
+}
+
+void begin() {
+    if (buffer) {
+        return;
+    }
+
+    RingbufHandle_t created = xRingbufferCreate(ASYNC_LOG_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!created) {
+        return;
+    }
+    buffer = created;
+    xTaskCreatePinnedToCore(drain, "AsyncLog", ASYNC_LOG_TASK_STACK, nullptr,
+        ASYNC_LOG_TASK_PRIORITY, &drainTask, ASYNC_LOG_TASK_CORE);
+}
+
+void write(uint8_t level, const char* format, std::initializer_list<Arg> args) {
+    uint8_t argc;
+    size_t cap;
+    size_t size = recordSize(args, argc, cap);
+
+    if (!buffer) {
+        uint8_t record[ASYNC_LOG_MAX_RECORD];
+        encode(record, level, format, args, argc, cap);
+        print(record, size);
+        return;
+    }
+
+    // Never waits: a full buffer drops the line rather than stalling the caller
+    void* slot = nullptr;
+    if (xRingbufferSendAcquire(buffer, &slot, size, 0) != pdTRUE || !slot) {
+        droppedRecords++;
+        return;
+    }
+    encode((uint8_t*)slot, level, format, args, argc, cap);
+    xRingbufferSendComplete(buffer, slot);
+}
+
+uint32_t dropped() {
+    return droppedRecords.load();
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <Arduino.h>
+#include <initializer_list>
+
+// Bytes of pending log records held between the producers and the drain task
+#define ASYNC_LOG_BUFFER_SIZE 4096
+// Largest encoded record. %s arguments share whatever the other arguments
+// leave of it and a string cut to fit ends in ASYNC_LOG_TRUNCATED; arguments
+// whose fixed part does not fit are printed as "<?>"
+#define ASYNC_LOG_MAX_RECORD 192
+#define ASYNC_LOG_TRUNCATED "..."
+#define ASYNC_LOG_TASK_STACK 4096
+#define ASYNC_LOG_TASK_PRIORITY 1
+#define ASYNC_LOG_TASK_CORE 0
+
+// Deferred-formatting logger. Producers copy the format pointer and the raw
+// argument values into a ring buffer without blocking and without touching
+// Serial; a low-priority task on core 0 formats and prints them. The format
+// must be a string literal, since only its address is stored. Until begin()
+// is called records are formatted and printed synchronously.
+namespace AsyncLog {
+
+enum ArgType : uint8_t {
+    ArgSigned,
+    ArgUnsigned,
+    ArgDouble,
+    ArgPointer,
+    ArgString
+};
+
+// One printf argument captured by value. Strings are copied when the record
+// is written, so temporaries such as String::c_str() are safe to pass.
+struct Arg {
+    ArgType type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;
+    };
+
+    Arg(char v) : type(ArgSigned), i(v) {}
+    Arg(signed char v) : type(ArgSigned), i(v) {}
+    Arg(short v) : type(ArgSigned), i(v) {}
+    Arg(int v) : type(ArgSigned), i(v) {}
+    Arg(long v) : type(ArgSigned), i(v) {}
+    Arg(long long v) : type(ArgSigned), i(v) {}
+    Arg(bool v) : type(ArgUnsigned), u(v) {}
+    Arg(unsigned char v) : type(ArgUnsigned), u(v) {}
+    Arg(unsigned short v) : type(ArgUnsigned), u(v) {}
+    Arg(unsigned int v) : type(ArgUnsigned), u(v) {}
+    Arg(unsigned long v) : type(ArgUnsigned), u(v) {}
+    Arg(unsigned long long v) : type(ArgUnsigned), u(v) {}
+    Arg(float v) : type(ArgDouble), d(v) {}
+    Arg(double v) : type(ArgDouble), d(v) {}
+    Arg(const char* v) : type(ArgString), s(v) {}
+    Arg(char* v) : type(ArgString), s(v) {}
+    template <typename T>
+    Arg(T* v) : type(ArgPointer), u((uintptr_t)v) {}
+};
+
+// Starts the drain task; safe to call more than once
+void begin();
+
+// Queues one line; drops it (and counts the drop) when the buffer is full
+void write(uint8_t level, const char* format, std::initializer_list<Arg> args);
+
+uint32_t dropped();
+
+// Never called at runtime: lets the LOG_* macros keep printf format checking
+inline void __attribute__((format(printf, 1, 2))) check(const char* format, ...) {}
+
+}
+
+#endif // ASYNC_LOG_H
@@ -7,8 +7,10 @@
 // define SERIAL_DEBUG on platformio.ini
 
 #ifdef SERIAL_DEBUG
+    #include "AsyncLog.h"
+
     // Enable debug macros
-    #define DEBUG_BEGIN(baud) Serial.begin(baud)
+    #define DEBUG_BEGIN(baud) do { Serial.begin(baud); AsyncLog::begin(); } while (0)
     #define DEBUG_PRINT(x) Serial.print(x)
     #define DEBUG_PRINTLN(x) Serial.println(x)
     #define DEBUG_PRINTF(...) Serial.printf(__VA_ARGS__)
@@ -31,21 +33,47 @@ enum DebugLevel {
     DEBUG_LEVEL_VERBOSE
 };
 
-// Set the maximum debug level that will be displayed
-#define CURRENT_DEBUG_LEVEL DEBUG_LEVEL_INFO
+// Set the maximum debug level that will be displayed. Numeric so the
+// preprocessor can drop disabled levels entirely; override with
+// -DSERIAL_DEBUG_LEVEL=<n> in platformio.ini.
+#ifndef SERIAL_DEBUG_LEVEL
+    #define SERIAL_DEBUG_LEVEL 2 // DEBUG_LEVEL_INFO
+#endif
+#define CURRENT_DEBUG_LEVEL ((DebugLevel)SERIAL_DEBUG_LEVEL)
 
+// LOG_* lines go through the asynchronous ring-buffer logger, so the caller
+// never waits on the UART. The format must be a string literal. Arguments are
+// copied into a record of ASYNC_LOG_MAX_RECORD (192) bytes: numbers take 9
+// bytes each and %s strings share the rest, so a long URL or JSON fragment is
+// cut and printed ending in "..."; %.*s is not supported.
 #ifdef SERIAL_DEBUG
-    #define LOG_ERROR(msg, ...) if(DEBUG_LEVEL_ERROR <= CURRENT_DEBUG_LEVEL) { Serial.print("[ERROR] "); Serial.printf(msg, ##__VA_ARGS__); Serial.println(); }
-    #define LOG_WARNING(msg, ...) if(DEBUG_LEVEL_WARNING <= CURRENT_DEBUG_LEVEL) { Serial.print("[WARNING] "); Serial.printf(msg, ##__VA_ARGS__); Serial.println(); }
-    #define LOG_INFO(msg, ...) if(DEBUG_LEVEL_INFO <= CURRENT_DEBUG_LEVEL) { Serial.print("[INFO] "); Serial.printf(msg, ##__VA_ARGS__); Serial.println(); }
-    #define LOG_DEBUG(msg, ...) if(DEBUG_LEVEL_DEBUG <= CURRENT_DEBUG_LEVEL) { Serial.print("[DEBUG] "); Serial.printf(msg, ##__VA_ARGS__); Serial.println(); }
-    #define LOG_VERBOSE(msg, ...) if(DEBUG_LEVEL_VERBOSE <= CURRENT_DEBUG_LEVEL) { Serial.print("[VERBOSE] "); Serial.printf(msg, ##__VA_ARGS__); Serial.println(); }
+    #define LOG_AT(level, msg, ...) do { if (false) { AsyncLog::check(msg, ##__VA_ARGS__); } AsyncLog::write(level, msg, { __VA_ARGS__ }); } while (0)
+#endif
+
+#if defined(SERIAL_DEBUG) && SERIAL_DEBUG_LEVEL >= 0
+    #define LOG_ERROR(msg, ...) LOG_AT(DEBUG_LEVEL_ERROR, msg, ##__VA_ARGS__)
+#else
+    #define LOG_ERROR(msg, ...) do {} while (0)
+#endif
+#if defined(SERIAL_DEBUG) && SERIAL_DEBUG_LEVEL >= 1
+    #define LOG_WARNING(msg, ...) LOG_AT(DEBUG_LEVEL_WARNING, msg, ##__VA_ARGS__)
+#else
+    #define LOG_WARNING(msg, ...) do {} while (0)
+#endif
+#if defined(SERIAL_DEBUG) && SERIAL_DEBUG_LEVEL >= 2
+    #define LOG_INFO(msg, ...) LOG_AT(DEBUG_LEVEL_INFO, msg, ##__VA_ARGS__)
+#else
+    #define LOG_INFO(msg, ...) do {} while (0)
+#endif
+#if defined(SERIAL_DEBUG) && SERIAL_DEBUG_LEVEL >= 3
+    #define LOG_DEBUG(msg, ...) LOG_AT(DEBUG_LEVEL_DEBUG, msg, ##__VA_ARGS__)
+#else
+    #define LOG_DEBUG(msg, ...) do {} while (0)
+#endif
+#if defined(SERIAL_DEBUG) && SERIAL_DEBUG_LEVEL >= 4
+    #define LOG_VERBOSE(msg, ...) LOG_AT(DEBUG_LEVEL_VERBOSE, msg, ##__VA_ARGS__)
 #else
-    #define LOG_ERROR(msg, ...)
-    #define LOG_WARNING(msg, ...)
-    #define LOG_INFO(msg, ...)
-    #define LOG_DEBUG(msg, ...)
-    #define LOG_VERBOSE(msg, ...)
+    #define LOG_VERBOSE(msg, ...) do {} while (0)
 #endif
 
-#endif // SERIAL_DEBUG_H
\ No newline at end of file
+#endif // SERIAL_DEBUG_H
@@ -0,0 +1,53 @@
+# Pre-compresses the web views and assets before the SPIFFS image is built.
+#
+# For every file under data/views and data/assets a "<name>.gz" sibling is
+# written (gzip level 9, fixed mtime so the output is reproducible). Response::file
+# serves the .gz variant with Content-Encoding: gzip to clients that accept it.
+
+Import("env")
+
+import gzip
+import os
+
+COMPRESS_DIRS = ("views", "assets")
+COMPRESS_EXTENSIONS = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt")
+SPIFFS_OBJ_NAME_LEN = 32  # includes the terminating NUL
+
+
+def compress_file(source, target):
+    with open(source, "rb") as src:
+        data = src.read()
+    with open(target, "wb") as dst:
+        with gzip.GzipFile(filename="", mode="wb", compresslevel=9, fileobj=dst, mtime=0) as gz:
+            gz.write(data)
+    return len(data), os.path.getsize(target)
+
+
+def compress_data(*args, **kwargs):
+    data_dir = env.subst("$PROJECT_DATA_DIR")
+
+    for folder in COMPRESS_DIRS:
+        root_dir = os.path.join(data_dir, folder)
+        if not os.path.isdir(root_dir):
+            continue
+
+        for root, _, files in os.walk(root_dir):
+            for name in files:
+                if not name.lower().endswith(COMPRESS_EXTENSIONS):
+                    continue
+
+                source = os.path.join(root, name)
+                target = source + ".gz"
+                spiffs_path = "/" + os.path.relpath(target, data_dir).replace(os.sep, "/")
+                if len(spiffs_path) >= SPIFFS_OBJ_NAME_LEN:
+                    print("compress_data: skipping %s, name too long for SPIFFS" % spiffs_path)
+                    continue
+
+                if os.path.exists(target) and os.path.getmtime(target) >= os.path.getmtime(source):
+                    continue
+
+                original, compressed = compress_file(source, target)
+                print("compress_data: %s %d -> %d bytes" % (spiffs_path, original, compressed))
+
+
+env.AddPreAction("$BUILD_DIR/${ESP32_FS_IMAGE_NAME}.bin", compress_data)
@@ -213,6 +213,10 @@ Response ApiController::getStats(Request& request) {
     statsData["requests_failed"] = stats["requests_failed"];
     statsData["bytes_sent"] = stats["bytes_sent"];
     statsData["bytes_received"] = stats["bytes_received"];
+    statsData["connections_opened"] = stats["connections_opened"];
+    statsData["connections_reused"] = stats["connections_reused"];
+    statsData["connections_evicted"] = stats["connections_evicted"];
+    statsData["connections_stale"] = stats["connections_stale"];
     
     // Calculate success rate
     float successRate = 0;
@@ -4,13 +4,10 @@
 
 Response AuthController::showLogin(Request& request) {
 		// Check if user is already authenticated
-		String token = request.header("Authorization");
-		if (token.length() > 0 && token.startsWith("Bearer ")) {
-				String authToken = token.substring(7);
-				if (verifyToken(authToken)) {
-						return Response(request.getServerRequest())
-								.redirect("/dashboard");
-				}
+		String token = AuthToken::fromHeader(request.header("Authorization"));
+		if (token.length() > 0 && verifyToken(token)) {
+				return Response(request.getServerRequest())
+						.redirect("/dashboard");
 		}
 		
 		// Serve login page from SPIFFS
@@ -60,7 +57,7 @@ Response AuthController::login(Request& request) {
 		// Get user data from database
 		user = User::findByUsername(username);
 		
-		// Generate JWT token
+		// Signed token with expiry
 		String token = generateToken(username);
 		
 		JsonDocument response;
@@ -127,60 +124,34 @@ bool AuthController::validateCredentials(const String& username, const String& p
 }
 
 String AuthController::generateToken(const String& username) {
-		// Simple token generation - in production use proper JWT library
-		// For demo, encode username in the token for easy extraction
-		String token = "cozmo_token_" + username + "_" + String(millis());
-		// In real implementation, use proper JWT encoding with signature
-		return token;
+		return AuthToken::issue(username);
 }
 
 bool AuthController::verifyToken(const String& token) {
-		// Simple token verification - in production use proper JWT verification
-		return token.startsWith("cozmo_token_") && token.length() > 20;
+		return AuthToken::verify(token);
 }
 
 String AuthController::extractUsernameFromToken(const String& token) {
-		// Simple username extraction - in production parse JWT payload
-		if (token.indexOf("cozmo_token_") == 0) {
-				// Extract username from token format: cozmo_token_username_timestamp
-				int firstUnderscore = token.indexOf('_', 11); // After "cozmo_token_"
-				int lastUnderscore = token.lastIndexOf('_');
-				
-				if (firstUnderscore != -1 && lastUnderscore != -1 && firstUnderscore != lastUnderscore) {
-						String username = token.substring(11, lastUnderscore); // Extract username part\
-						return username;
-				}
+		String username;
+		if (!AuthToken::verify(token, &username)) {
+				return "";
 		}
-		return "";
+		return username;
 }
 
 // Static helper methods for other controllers
 String AuthController::getCurrentUserUsername(Request& request) {
-		String token = request.header("Authorization");
-		
+		String token = AuthToken::fromHeader(request.header("Authorization"));
 		if (token.length() == 0) {
 				return "";
 		}
 		
-		if (token.startsWith("Bearer ")) {
-				token = token.substring(7);
-		}
-		
-		// Simple token verification - in production use proper JWT
-		if (!token.startsWith("cozmo_token_")) {
+		// Signed username; repeat calls hit the verification cache
+		String username;
+		if (!AuthToken::verify(token, &username)) {
 				return "";
 		}
-		
-		// Extract username from token format: cozmo_token_username_timestamp
-		int tokenPrefix = String("cozmo_token_").length();
-		int lastUnderscore = token.lastIndexOf('_');
-		
-		if (lastUnderscore != -1) {
-				String username = token.substring(tokenPrefix, lastUnderscore); // Extract username part
-				return username;
-		}
-		
-		return "";
+		return username;
 }
 
 User* AuthController::getCurrentUser(Request& request) {
@@ -15,7 +15,7 @@ Response IoTDeviceController::getAllDevices(Request& request) {
     
     doc["total"] = devices.size();
     
-    return json(request.getServerRequest(), doc);
+    return jsonStream(request.getServerRequest(), std::move(doc));
 }
 
 Response IoTDeviceController::getOnlineDevices(Request& request) {
@@ -32,7 +32,7 @@ Response IoTDeviceController::getOnlineDevices(Request& request) {
     
     doc["total"] = devices.size();
     
-    return json(request.getServerRequest(), doc);
+    return jsonStream(request.getServerRequest(), std::move(doc));
 }
 
 Response IoTDeviceController::getDevice(Request& request) {
@@ -169,7 +169,7 @@ Response IoTDeviceController::getDevicesByType(Request& request) {
     
     doc["total"] = devices.size();
     
-    return json(request.getServerRequest(), doc);
+    return jsonStream(request.getServerRequest(), std::move(doc));
 }
 
 Response IoTDeviceController::getDevicesByCapability(Request& request) {
@@ -194,7 +194,7 @@ Response IoTDeviceController::getDevicesByCapability(Request& request) {
     
     doc["total"] = devices.size();
     
-    return json(request.getServerRequest(), doc);
+    return jsonStream(request.getServerRequest(), std::move(doc));
 }
 
 Response IoTDeviceController::scanDevices(Request& request) {
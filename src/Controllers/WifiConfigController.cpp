@@ -21,8 +21,7 @@ Response WifiConfigController::getConfigurations(Request& request) {
 }
 
 Response WifiConfigController::saveConfiguration(Request& request) {
-    JsonDocument doc;
-    deserializeJson(doc, request.getBody());
+    JsonDocument doc = request.json();
     
     String ssid = doc["ssid"] | "";
     String password = doc["password"] | "";
@@ -162,8 +161,7 @@ Response WifiConfigController::scanNetworks(Request& request) {
 }
 
 Response WifiConfigController::connectToNetwork(Request& request) {
-    JsonDocument doc;
-    deserializeJson(doc, request.getBody());
+    JsonDocument doc = request.json();
     
     String ssid = doc["ssid"] | "";
     String password = doc["password"] | "";
@@ -70,8 +70,7 @@ Response WifiController::scan(Request& request) {
 
 Response WifiController::startAP(Request& request) {
     // Extract parameters from request
-    JsonDocument doc;
-    deserializeJson(doc, request.getBody());
+    JsonDocument doc = request.json();
     
     String ssid = doc["ssid"] | "";
     String password = doc["password"] | "";
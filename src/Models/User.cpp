@@ -12,17 +12,49 @@ void User::hashPassword(const String& password) {
     setPassword(password);
 }
 
+// Rows looked up by username, dropped whenever the users table is written
+static std::map<String, std::map<String, String>> recordCache;
+static uint32_t recordCacheVersion = 0;
+static SemaphoreHandle_t recordCacheMutex = NULL;
+
 User* User::findByUsername(const String& username) {
     if (!database) {
         return nullptr;
     }
     
-    std::map<String, String> where;
-    where["username"] = username;
+    if (recordCacheMutex == NULL) {
+        recordCacheMutex = xSemaphoreCreateMutex();
+    }
+    
+    std::map<String, String> record;
+    uint32_t version = database->getTableVersion("users");
+    
+    xSemaphoreTake(recordCacheMutex, portMAX_DELAY);
+    if (recordCacheVersion != version) {
+        recordCache.clear();
+        recordCacheVersion = version;
+    }
+    auto it = recordCache.find(username);
+    if (it != recordCache.end()) {
+        record = it->second;
+    }
+    xSemaphoreGive(recordCacheMutex);
     
-    auto record = database->findWhere("users", where);
     if (record.empty()) {
-        return nullptr;
+        std::map<String, String> where;
+        where["username"] = username;
+        
+        record = database->findWhere("users", where);
+        if (record.empty()) {
+            return nullptr;
+        }
+        
+        xSemaphoreTake(recordCacheMutex, portMAX_DELAY);
+        // A write that landed while the file was read makes this row stale
+        if (database->getTableVersion("users") == recordCacheVersion) {
+            recordCache[username] = record;
+        }
+        xSemaphoreGive(recordCacheMutex);
     }
     
     User* user = new User();
@@ -5,7 +5,8 @@ void registerIoTRoutes(Router* router, IoTDeviceManager* iotManager) {
     IoTDeviceController* iotController = new IoTDeviceController(iotManager);
     
     router->group("/api/v1/iot", [&](Router& iot) {
-        iot.middleware({"cors", "json"});
+        // GETs are cached for dashboard polling; commands, scans and discovery invalidate the "iot" tag
+        iot.middleware({"cors", "json", "cache:5,iot"});
         
         // Device discovery and management
         iot.get("/devices", [iotController](Request& request) -> Response {
@@ -20,17 +21,23 @@ void registerIoTRoutes(Router* router, IoTDeviceManager* iotManager) {
             return iotController->getDevice(request);
         }).name("api.iot.device");
         
-        iot.get("/devices/{id}/info", [iotController](Request& request) -> Response {
-            return iotController->getDeviceInfo(request);
-        }).name("api.iot.device.info");
-        
-        iot.post("/devices/{id}/command", [iotController](Request& request) -> Response {
-            return iotController->executeCommand(request);
-        }).name("api.iot.device.command");
-        
-        iot.post("/devices/{id}/refresh", [iotController](Request& request) -> Response {
-            return iotController->refreshDevice(request);
-        }).name("api.iot.device.refresh");
+        // These call out to the device over HTTP: run them on a worker, two at a
+        // time with four waiting; beyond that the client gets 503 + Retry-After
+        iot.group("", [&](Router& device) {
+            device.limit(2, 4);
+            
+            device.getAsync("/devices/{id}/info", [iotController](Request& request) -> Response {
+                return iotController->getDeviceInfo(request);
+            }).name("api.iot.device.info");
+            
+            device.postAsync("/devices/{id}/command", [iotController](Request& request) -> Response {
+                return iotController->executeCommand(request);
+            }).name("api.iot.device.command");
+            
+            device.postAsync("/devices/{id}/refresh", [iotController](Request& request) -> Response {
+                return iotController->refreshDevice(request);
+            }).name("api.iot.device.refresh");
+        });
         
         // Device filtering
         iot.get("/devices/types/{type}", [iotController](Request& request) -> Response {
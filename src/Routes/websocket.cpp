@@ -1,6 +1,12 @@
 #include "routes.h"
 
 void registerWebSocketRoutes(Router* router) {
+		// Topics clients may subscribe to; anything else is refused
+		WebSocketHub* hub = WebSocketHub::getInstance();
+		for (const char* topic : {"wifi", "iot", "mic", "camera"}) {
+				hub->registerTopic(topic);
+		}
+		
 		// WiFi clients WebSocket for real-time updates
 		router->websocket("/ws/wifi")
 				.onConnect([](WebSocketRequest& request) {
@@ -30,18 +36,50 @@ void registerWebSocketRoutes(Router* router) {
 						
 						String command = doc["command"].as<String>();
 						
-						if (command == "subscribe") {
-								// Handle subscription request
+						if (command == "subscribe" || command == "unsubscribe") {
+								// Topics registered above; published through WebSocketHub
 								String topic = doc["topic"].as<String>();
 								
+								bool success = true;
+								if (command == "subscribe") {
+										success = request.subscribe(topic);
+								} else {
+										request.unsubscribe(topic);
+								}
+								
 								JsonDocument response;
 								response["type"] = "subscription";
-								response["status"] = "success";
+								response["status"] = success ? "success" : "error";
 								response["topic"] = topic;
+								response["subscribed"] = command == "subscribe" && success;
 								
 								String responseMsg;
 								serializeJson(response, responseMsg);
 								request.send(responseMsg);
 						}
 				});
-}
\ No newline at end of file
+		
+		// Versioned dashboard state: a snapshot on connect, then patches since
+		// the version each client last acknowledged
+		router->websocket("/ws/state")
+				.onConnect([](WebSocketRequest& request) {
+						LiveState::getInstance()->join(request.clientId());
+				})
+				.onDisconnect([](WebSocketRequest& request) {
+						LiveState::getInstance()->leave(request.clientId());
+				})
+				.onMessage([](WebSocketRequest& request, const String& message) {
+						JsonDocument doc;
+						if (deserializeJson(doc, message)) {
+								return;
+						}
+						
+						String command = doc["command"].as<String>();
+						if (command == "ack") {
+								LiveState::getInstance()->acknowledge(request.clientId(), doc["version"] | 0u);
+						} else if (command == "resync") {
+								LiveState::getInstance()->resync(request.clientId());
+						}
+				});
+		LiveState::getInstance()->attach(router->getOutbox("/ws/state"));
+}
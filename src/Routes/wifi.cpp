@@ -9,15 +9,32 @@ void registerWifiRoutes(Router* router, WiFiManager* wifiManager) {
 		router->group("/api/wifi", [&](Router& wifi) {
 				wifi.middleware({"cors", "json"});  // Add authentication middleware in production
 				
-				// Status endpoint
-				wifi.get("/status", [wifiController](Request& request) -> Response {
-						return wifiController->status(request);
-				}).name("api.wifi.status");
+				// Polled by the dashboard; WiFi events invalidate the "wifi" tag
+				wifi.group("", [&](Router& polled) {
+						polled.middleware("cache:5,wifi");
+						
+						// Status endpoint
+						polled.get("/status", [wifiController](Request& request) -> Response {
+								return wifiController->status(request);
+						}).name("api.wifi.status");
+						
+						polled.get("/clients", [wifiController](Request& request) -> Response {
+								return wifiController->getClients(request);
+						}).name("api.wifi.clients");
+				});
 				
-				// Scan endpoint
-				wifi.get("/scan", [wifiController](Request& request) -> Response {
-						return wifiController->scan(request);
-				}).name("api.wifi.scan");
+				// Scans block for seconds; run them on a worker, one at a time
+				wifi.group("", [&](Router& scan) {
+						scan.limit(1, 2);
+						
+						scan.getAsync("/scan", [wifiController](Request& request) -> Response {
+								return wifiController->scan(request);
+						}).name("api.wifi.scan");
+						
+						scan.postAsync("/scan", [wifiConfigController](Request& request) -> Response {
+								return wifiConfigController->scanNetworks(request);
+						}).name("api.wifi.scan.networks");
+				});
 				
 				// AP management endpoints
 				wifi.post("/ap", [wifiController](Request& request) -> Response {
@@ -33,41 +50,34 @@ void registerWifiRoutes(Router* router, WiFiManager* wifiManager) {
 				}).name("api.wifi.ap.stop");
 				
 				// Client management endpoints
-				wifi.get("/clients", [wifiController](Request& request) -> Response {
-						return wifiController->getClients(request);
-				}).name("api.wifi.clients");
-				
 				wifi.post("/clients/{id}/disconnect", [wifiController](Request& request) -> Response {
 						return wifiController->disconnectClient(request);
 				}).name("api.wifi.clients.disconnect");
 				
-				// WiFi configuration endpoints
-				wifi.get("/config", [wifiConfigController](Request& request) -> Response {
+				// WiFi configuration endpoints; the CSV database is only touched off the network task,
+				// so a read never waits on AsyncTCP behind another worker's write
+				wifi.getAsync("/config", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->getConfigurations(request);
 				}).name("api.wifi.config.list");
 				
-				wifi.post("/config", [wifiConfigController](Request& request) -> Response {
+				wifi.postAsync("/config", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->saveConfiguration(request);
 				}).name("api.wifi.config.save");
 				
-				wifi.delete_("/config/{id}", [wifiConfigController](Request& request) -> Response {
+				wifi.deleteAsync("/config/{id}", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->deleteConfiguration(request);
 				}).name("api.wifi.config.delete");
 				
-				wifi.post("/config/{id}/connect", [wifiConfigController](Request& request) -> Response {
+				wifi.postAsync("/config/{id}/connect", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->connectToSaved(request);
 				}).name("api.wifi.config.connect");
 				
-				wifi.post("/scan", [wifiConfigController](Request& request) -> Response {
-						return wifiConfigController->scanNetworks(request);
-				}).name("api.wifi.scan.networks");
-				
-				wifi.post("/connect", [wifiConfigController](Request& request) -> Response {
+				wifi.postAsync("/connect", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->connectToNetwork(request);
 				}).name("api.wifi.connect");
 				
 				// Route to clean up invalid networks
-				wifi.get("/cleanup-networks", [wifiConfigController](Request& request) -> Response {
+				wifi.getAsync("/cleanup-networks", [wifiConfigController](Request& request) -> Response {
 						return wifiConfigController->cleanUpNetworks(request);
 				}).name("api.wifi.cleanup-networks");
 		});
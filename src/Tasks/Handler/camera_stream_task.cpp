@@ -16,6 +16,7 @@ static bool cameraStreamActive = false;
 static String currentCameraDeviceId = "";
 static unsigned long lastCaptureTime = 0;
 static const unsigned long CAPTURE_INTERVAL = 500; // 500ms for 2 FPS (faster streaming)
+static const unsigned long CAPTURE_TIMEOUT = 2000; // A stalled capture is dropped, the next frame retries
 
 // JPEG display variables
 static int jpegDisplayX, jpegDisplayY, jpegDisplayMaxW, jpegDisplayMaxH;
@@ -55,18 +56,18 @@ int jpegDrawCallback(JPEGDRAW *pDraw) {
  */
 bool captureJpegBinary(const IoTDevice& device, uint8_t*& jpegData, size_t& jpegSize) {
     if (httpClientManager == nullptr) {
-        DEBUG_PRINTLN("Camera capture: HttpClientManager not available");
+        LOG_ERROR("Camera capture: HttpClientManager not available");
         return false;
     }
     
     String captureUrl = device.baseUrl + "/api/v1/camera/capture";
-    DEBUG_PRINTF("Camera capture: Requesting JPEG from %s\n", captureUrl.c_str());
+    LOG_DEBUG("Camera capture: Requesting JPEG from %s", captureUrl.c_str());
     
     // Make POST request to capture endpoint
-    HttpResponse response = httpClientManager->post(captureUrl, "", "application/json");
+    HttpResponse response = httpClientManager->request(HTTP_POST, captureUrl, "", "application/json", {}, CAPTURE_TIMEOUT);
     
     if (response.statusCode != 200) {
-        DEBUG_PRINTF("Camera capture: HTTP error %d\n", response.statusCode);
+        LOG_WARNING("Camera capture: HTTP error %d", response.statusCode);
         return false;
     }
     
@@ -82,16 +83,16 @@ bool captureJpegBinary(const IoTDevice& device, uint8_t*& jpegData, size_t& jpeg
             jpegData = new uint8_t[jpegSize];
             memcpy(jpegData, response.body.c_str(), jpegSize);
             
-            DEBUG_PRINTF("Camera capture: Received JPEG binary data (%d bytes)\n", jpegSize);
+            LOG_DEBUG("Camera capture: Received JPEG binary data (%u bytes)", (unsigned)jpegSize);
             return true;
         }
     } else {
-        DEBUG_PRINTLN("Camera capture: Response is not JPEG binary data");
+        LOG_WARNING("Camera capture: Response is not JPEG binary data");
         // Try to parse as JSON error response
         JsonDocument errorDoc;
         DeserializationError error = deserializeJson(errorDoc, response.body);
         if (!error && errorDoc["success"].as<bool>() == false) {
-            DEBUG_PRINTF("Camera capture: Error - %s\n", errorDoc["message"].as<String>().c_str());
+            LOG_WARNING("Camera capture: Error - %s", errorDoc["message"].as<String>().c_str());
         }
     }
     
@@ -126,7 +127,7 @@ bool isValidJpeg(const uint8_t* data, size_t size) {
 bool displayJpegOnTFT(const uint8_t* jpegData, size_t jpegSize, 
                       int x, int y, int maxWidth, int maxHeight) {
     if (!isValidJpeg(jpegData, jpegSize)) {
-        DEBUG_PRINTLN("Display JPEG: Invalid JPEG data");
+        LOG_WARNING("Display JPEG: Invalid JPEG data");
         return false;
     }
     
@@ -136,7 +137,7 @@ bool displayJpegOnTFT(const uint8_t* jpegData, size_t jpegSize,
     // Open JPEG from RAM
     int result = jpeg.openRAM((uint8_t*)jpegData, jpegSize, jpegDrawCallback);
     if (result != 1) {
-        DEBUG_PRINTF("Display JPEG: Failed to open JPEG, error: %d\n", jpeg.getLastError());
+        LOG_WARNING("Display JPEG: Failed to open JPEG, error: %d", jpeg.getLastError());
         return false;
     }
     
@@ -180,7 +181,7 @@ bool displayJpegOnTFT(const uint8_t* jpegData, size_t jpegSize,
     
     // Take mutex for entire decode operation (single mutex operation for speed)
     if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
-        DEBUG_PRINTLN("Display JPEG: Failed to take display mutex for decode");
+        LOG_WARNING("Display JPEG: Failed to take display mutex for decode");
         jpeg.close();
         return false;
     }
@@ -198,7 +199,7 @@ bool displayJpegOnTFT(const uint8_t* jpegData, size_t jpegSize,
     jpeg.close();
     
     if (result != 1) {
-        DEBUG_PRINTF("Display JPEG: Failed to decode JPEG, error: %d\n", jpeg.getLastError());
+        LOG_WARNING("Display JPEG: Failed to decode JPEG, error: %d", jpeg.getLastError());
         
         // Show error message on display
         if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
@@ -228,7 +229,7 @@ void startCameraStream(const String& deviceId) {
     cameraStreamActive = true;
     lastCaptureTime = 0;
     
-    DEBUG_PRINTF("Camera stream: Starting stream from device %s\n", deviceId.c_str());
+    LOG_INFO("Camera stream: Starting stream from device %s", deviceId.c_str());
     
     // Create camera stream task on Core 1 (same as display tasks)
     xTaskCreatePinnedToCore(
@@ -248,7 +249,7 @@ void startCameraStream(const String& deviceId) {
 void stopCameraStream() {
     if (!cameraStreamActive) return;
     
-    DEBUG_PRINTLN("Camera stream: Stopping stream");
+    LOG_INFO("Camera stream: Stopping stream");
     
     cameraStreamActive = false;
     currentCameraDeviceId = "";
@@ -281,7 +282,7 @@ String getCurrentStreamingDevice() {
  * @param parameter Task parameter (unused)
  */
 void cameraStreamTask(void* parameter) {
-    DEBUG_PRINTLN("Camera stream task: Started");
+    LOG_INFO("Camera stream task: Started");
     
     while (cameraStreamActive && iotDeviceManager != nullptr) {
         unsigned long currentTime = millis();
@@ -292,13 +293,13 @@ void cameraStreamTask(void* parameter) {
             IoTDevice* device = iotDeviceManager->getDevice(currentCameraDeviceId);
             
             if (device == nullptr || !device->isOnline) {
-                DEBUG_PRINTF("Camera stream: Device %s not available\n", currentCameraDeviceId.c_str());
+                LOG_WARNING("Camera stream: Device %s not available", currentCameraDeviceId.c_str());
                 break;
             }
             
             // Check if device still has camera capability
             if (!(device->capabilities & static_cast<uint32_t>(DeviceCapability::CAMERA))) {
-                DEBUG_PRINTF("Camera stream: Device %s lost camera capability\n", currentCameraDeviceId.c_str());
+                LOG_WARNING("Camera stream: Device %s lost camera capability", currentCameraDeviceId.c_str());
                 break;
             }
             
@@ -324,12 +325,24 @@ void cameraStreamTask(void* parameter) {
                     xSemaphoreGive(displayMutex);
                 }
                 
+                // Tell subscribed dashboards a new frame is on screen
+                WebSocketHub* hub = WebSocketHub::getInstance();
+                if (hub->hasSubscribers("camera")) {
+                    JsonDocument update;
+                    update["type"] = "event";
+                    update["topic"] = "camera";
+                    update["event"] = "frame";
+                    update["device"] = currentCameraDeviceId;
+                    update["bytes"] = jpegSize;
+                    hub->publish("camera", update);
+                }
+                
                 // Clean up JPEG data
                 delete[] jpegData;
                 jpegData = nullptr;
                 
             } else {
-                DEBUG_PRINTLN("Camera stream: JPEG capture failed");
+                LOG_WARNING("Camera stream: JPEG capture failed");
                 
                 // Update display with error
                 if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
@@ -345,7 +358,7 @@ void cameraStreamTask(void* parameter) {
         vTaskDelay(pdMS_TO_TICKS(50));
     }
     
-    DEBUG_PRINTLN("Camera stream task: Ended");
+    LOG_INFO("Camera stream task: Ended");
     cameraStreamActive = false;
     vTaskDelete(NULL);
 }
@@ -395,7 +408,7 @@ bool triggerManualCapture() {
         return false;
     }
     
-    DEBUG_PRINTF("Camera stream: Manual capture from device %s\n", currentCameraDeviceId.c_str());
+    LOG_INFO("Camera stream: Manual capture from device %s", currentCameraDeviceId.c_str());
     
     // Use new JPEG binary capture
     uint8_t* jpegData = nullptr;
@@ -404,7 +417,7 @@ bool triggerManualCapture() {
     bool success = captureJpegBinary(*device, jpegData, jpegSize);
     
     if (success && jpegData != nullptr) {
-        DEBUG_PRINTF("Camera stream: Manual JPEG captured (%d bytes)\n", jpegSize);
+        LOG_INFO("Camera stream: Manual JPEG captured (%u bytes)", (unsigned)jpegSize);
         
         // Display immediately (displayJpegOnTFT will handle the mutex)
         displayJpegOnTFT(jpegData, jpegSize, 10, 70, 220, 120);
@@ -425,7 +438,7 @@ bool triggerManualCapture() {
         delete[] jpegData;
         jpegData = nullptr;
     } else {
-        DEBUG_PRINTLN("Camera stream: Manual JPEG capture failed");
+        LOG_WARNING("Camera stream: Manual JPEG capture failed");
     }
     
     return success;
@@ -5,27 +5,24 @@ TaskHandle_t displayUpdateTaskHandle = NULL;
 void displayUpdateTask(void* parameter) {
   TickType_t lastWakeTime = xTaskGetTickCount();
   const TickType_t updateFrequency = pdMS_TO_TICKS(5000); // 5 seconds
+  MenuState drawnMenu = currentMenu;
+  uint32_t drawnClientsVersion = 0;
   
   for (;;) {
     // Wait for the next cycle
     vTaskDelayUntil(&lastWakeTime, updateFrequency);
     
     if (currentMenu == MENU_WIFI_STATUS || currentMenu == MENU_CLIENTS) {
-      // Check for client info updates
-      std::vector<ClientInfo> clients = wifiManager.getConnectedClients();
-      if (!clients.empty()) {
-        // Print client information to serial for debugging
-        DEBUG_PRINTLN("Connected clients:");
-        for (const auto& client : clients) {
-          DEBUG_PRINTF("MAC: %s, IP: %s, Hostname: %s\n", 
-                     client.macAddress.c_str(), 
-                     client.ipAddress.c_str(), 
-                     client.hostname.c_str());
-        }
+      // The client list only changes on WiFi events, which bump its live state version
+      uint32_t clientsVersion = LiveState::getInstance()->getVersion("wifi_clients");
+      if (currentMenu == MENU_CLIENTS && drawnMenu == MENU_CLIENTS && clientsVersion == drawnClientsVersion) {
+        continue;
       }
       
       // Update the display if we can get the mutex
       if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        drawnMenu = currentMenu;
+        drawnClientsVersion = clientsVersion;
         if (currentMenu == MENU_WIFI_STATUS) {
           displayWiFiStatus();
         } else if (currentMenu == MENU_CLIENTS) {
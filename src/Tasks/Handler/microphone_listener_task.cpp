@@ -30,10 +30,21 @@ void microphoneListenerTask(void* param) {
 			continue;
 		}
 	
+		int level = analogMicrophone->readPeakLevel(frequency);
+	
 		// Update the display if we can get the mutex
 		if (xSemaphoreTake(displayMutex, micListenFrequency) == pdTRUE) {
-			micbar->drawBar(analogMicrophone->readPeakLevel(frequency));
+			micbar->drawBar(level);
 			xSemaphoreGive(displayMutex);
 		}
+		
+		WebSocketHub* hub = WebSocketHub::getInstance();
+		if (hub->hasSubscribers("mic")) {
+			JsonDocument update;
+			update["type"] = "event";
+			update["topic"] = "mic";
+			update["level"] = level;
+			hub->publish("mic", update);
+		}
 	}
 }
\ No newline at end of file
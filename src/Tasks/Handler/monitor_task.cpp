@@ -17,6 +17,19 @@ void memoryMonitorTask(void* parameter) {
     // Print memory information
     printMemoryInfo("Periodic memory check");
     
+    // Rounded to KB so that small fluctuations do not produce patches
+    JsonDocument stats;
+    stats["free_heap_kb"] = ESP.getFreeHeap() / 1024;
+    stats["min_free_heap_kb"] = ESP.getMinFreeHeap() / 1024;
+    stats["max_alloc_kb"] = ESP.getMaxAllocHeap() / 1024;
+    #ifdef BOARD_HAS_PSRAM
+    stats["free_psram_kb"] = ESP.getFreePsram() / 1024;
+    #endif
+    stats["tasks"] = uxTaskGetNumberOfTasks();
+    LiveState* state = LiveState::getInstance();
+    state->set("system", "memory", stats);
+    state->commit();
+    
     // Print additional task information
     DEBUG_PRINTF("Current task count: %d\n", uxTaskGetNumberOfTasks());
     DEBUG_PRINTF("Task high water mark: %d\n", uxTaskGetStackHighWaterMark(NULL));
@@ -1,5 +1,34 @@
 #include "tasks.h"
 
+// Records a device change in the live state and pushes it to dashboards
+// subscribed to the "iot" topic
+static void publishDeviceUpdate(const char* event, const IoTDevice& device) {
+  JsonDocument entry;
+  entry["name"] = device.name;
+  entry["ip"] = device.ipAddress;
+  entry["type"] = IoTDeviceManager::deviceTypeToString(device.type);
+  entry["online"] = device.isOnline;
+  LiveState* state = LiveState::getInstance();
+  state->set("iot_devices", device.id, entry);
+  state->commit();
+  
+  WebSocketHub* hub = WebSocketHub::getInstance();
+  if (!hub->hasSubscribers("iot")) {
+    return;
+  }
+  
+  JsonDocument update;
+  update["type"] = "event";
+  update["topic"] = "iot";
+  update["event"] = event;
+  update["device"] = device.id;
+  update["name"] = device.name;
+  update["ip"] = device.ipAddress;
+  update["online"] = device.isOnline;
+  // One pending update per device; a newer one replaces it for slow clients
+  hub->publish("iot", update, "iot:" + device.id);
+}
+
 void setupTasks() {
   // Initialize camera stream task handle
   cameraStreamTaskHandle = NULL;
@@ -58,23 +87,43 @@ void setupTasks() {
   xTaskCreate(
     microphoneListenerTask,
     "microphoneListenerTask",
-    2048,
+    4096,                     // room for publishing levels to WebSocket subscribers
     NULL,
     5,
     &microphoneListenerTaskHandle
   );
   
   // Set up device discovery callbacks
+  // Device changes drop cached /api/v1/iot responses
   iotDeviceManager->setDeviceDiscoveredCallback([](const IoTDevice& device) {
-    DEBUG_PRINTF("New IoT device discovered: %s (%s) - %s\n", 
-                device.name.c_str(), device.ipAddress.c_str(), 
-                IoTDeviceManager::deviceTypeToString(device.type).c_str());
+    ResponseCache::getInstance()->invalidate("iot");
+    publishDeviceUpdate("discovered", device);
+    LOG_INFO("New IoT device discovered: %s (%s) - %s",
+             device.name.c_str(), device.ipAddress.c_str(),
+             IoTDeviceManager::deviceTypeToString(device.type).c_str());
   });
   
   iotDeviceManager->setDeviceStatusCallback([](const IoTDevice& device, bool isOnline) {
-    DEBUG_PRINTF("Device %s (%s) is now %s\n", 
-                device.name.c_str(), device.ipAddress.c_str(),
-                isOnline ? "online" : "offline");
+    ResponseCache::getInstance()->invalidate("iot");
+    publishDeviceUpdate("status", device);
+    LOG_INFO("Device %s (%s) is now %s",
+             device.name.c_str(), device.ipAddress.c_str(),
+             isOnline ? "online" : "offline");
+  });
+  
+  // Scan statistics change after every scan
+  iotDeviceManager->setScanCompleteCallback([](int newDevices) {
+    ResponseCache::getInstance()->invalidate("iot");
+    
+    WebSocketHub* hub = WebSocketHub::getInstance();
+    if (hub->hasSubscribers("iot")) {
+      JsonDocument update;
+      update["type"] = "event";
+      update["topic"] = "iot";
+      update["event"] = "scan_complete";
+      update["new_devices"] = newDevices;
+      hub->publish("iot", update, "iot:scan");
+    }
   });
   
   // Start device discovery with 30 second interval
@@ -57,6 +57,7 @@ void initialize() {
       uint32_t ipAddr = info.got_ip.ip_info.ip.addr;
       IPAddress clientIP(ipAddr);
       char macStr[18] = { 0 };
+      const char* eventName = nullptr;
       switch (event) {
         case ARDUINO_EVENT_WIFI_AP_STACONNECTED:
           sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -65,6 +66,7 @@ void initialize() {
             info.wifi_ap_staconnected.mac[4], info.wifi_ap_staconnected.mac[5]);
           
           DEBUG_PRINTF("Client connected: %s\n", macStr);
+          eventName = "client_connected";
           break;
         case ARDUINO_EVENT_WIFI_AP_STADISCONNECTED:
           sprintf(macStr, "%02X:%02X:%02X:%02X:%02X:%02X",
@@ -73,11 +75,44 @@ void initialize() {
             info.wifi_ap_stadisconnected.mac[4], info.wifi_ap_stadisconnected.mac[5]);
             
           DEBUG_PRINTF("Client disconnected: %s\n", macStr);
+          eventName = "client_disconnected";
           break;
         case ARDUINO_EVENT_WIFI_AP_STAIPASSIGNED:
           DEBUG_PRINTF("Client assigned: %s\n", clientIP.toString());
+          eventName = "client_ip_assigned";
           break;
       }
+      
+      // Status and client lists served from the response cache are stale now
+      ResponseCache::getInstance()->invalidate("wifi");
+      
+      WebSocketHub* hub = WebSocketHub::getInstance();
+      if (eventName && hub->hasSubscribers("wifi")) {
+        JsonDocument update;
+        update["type"] = "event";
+        update["topic"] = "wifi";
+        update["event"] = eventName;
+        if (macStr[0]) {
+          update["mac"] = macStr;
+        }
+        update["clients"] = WiFi.softAPgetStationNum();
+        // Keyed per event, so a slow dashboard still sees each kind of change
+        hub->publish("wifi", update, String("wifi:") + eventName);
+      }
+      
+      if (eventName) {
+        // Live state keyed by MAC; /ws/state subscribers get only the difference
+        JsonDocument clients;
+        for (const ClientInfo& client : wifiManager.getConnectedClients()) {
+          JsonObject entry = clients[client.macAddress].to<JsonObject>();
+          entry["ip_address"] = client.ipAddress;
+          entry["hostname"] = client.hostname;
+          entry["connection_time"] = client.connectionTime;
+        }
+        LiveState* state = LiveState::getInstance();
+        state->replace("wifi_clients", clients);
+        state->commit();
+      }
     });
   } else {
     DEBUG_PRINTLN("Failed to start WiFi AP");
@@ -31,6 +31,7 @@ void setup() {
     
   // Register routes
   Router* router = app->getRouter();
+  router->workerPool(2, 0);  // core 0, away from AsyncTCP: device calls, WiFi scans, CSV access
   registerWebRoutes(router);
   registerApiRoutes(router);
   registerWebSocketRoutes(router);
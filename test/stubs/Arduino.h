@@ -0,0 +1,56 @@
+#ifndef NATIVE_ARDUINO_STUB_H
+#define NATIVE_ARDUINO_STUB_H
+
+// Just enough of the Arduino core for framework code that only needs
+// String, so it can be compiled and tested in [env:native]
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+class String {
+private:
+    std::string text;
+
+public:
+    String() {}
+    String(const char* value) : text(value ? value : "") {}
+    String(const std::string& value) : text(value) {}
+    explicit String(int value) : text(std::to_string(value)) {}
+    explicit String(unsigned value) : text(std::to_string(value)) {}
+
+    unsigned int length() const { return text.length(); }
+    const char* c_str() const { return text.c_str(); }
+    char charAt(unsigned int index) const { return index < text.length() ? text[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t found = text.find(c, from);
+        return found == std::string::npos ? -1 : (int)found;
+    }
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.length(), prefix.text) == 0; }
+    bool endsWith(const String& suffix) const {
+        return text.length() >= suffix.text.length() &&
+               text.compare(text.length() - suffix.text.length(), suffix.text.length(), suffix.text) == 0;
+    }
+
+    String substring(unsigned int from) const { return substring(from, text.length()); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= text.length()) return String();
+        return String(text.substr(from, to - from));
+    }
+
+    String& operator+=(const String& other) { text += other.text; return *this; }
+    String& operator+=(const char* other) { text += other ? other : ""; return *this; }
+    String& operator+=(char c) { text += c; return *this; }
+
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator!=(const String& other) const { return text != other.text; }
+    bool operator<(const String& other) const { return text < other.text; }
+    String operator+(const String& other) const { return String(text + other.text); }
+};
+
+#endif
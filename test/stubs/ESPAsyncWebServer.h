@@ -0,0 +1,21 @@
+#ifndef NATIVE_ESP_ASYNC_WEB_SERVER_STUB_H
+#define NATIVE_ESP_ASYNC_WEB_SERVER_STUB_H
+
+// Request method constants as declared by ESPAsyncWebServer
+
+#include <Arduino.h>
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+#endif
@@ -0,0 +1,177 @@
+// Host-side tests and measurement for JsonChunkSerializer: pio test -e native
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <string>
+#include "../../lib/MVCFramework/src/Http/JsonChunkSerializer.cpp"
+
+// Heap accounting for the measurement below. ArduinoJson allocates the
+// document with malloc, so only what the serializer itself allocates is
+// counted here.
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+
+void* operator new(size_t size) {
+    size_t* block = (size_t*)malloc(size + sizeof(size_t));
+    if (!block) throw std::bad_alloc();
+    *block = size;
+    liveBytes += size;
+    if (liveBytes > peakBytes) peakBytes = liveBytes;
+    return block + 1;
+}
+
+void operator delete(void* memory) noexcept {
+    if (!memory) return;
+    size_t* block = (size_t*)memory - 1;
+    liveBytes -= *block;
+    free(block);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    operator delete(memory);
+}
+
+// Same shape as GET /api/v1/iot/devices
+static std::shared_ptr<JsonDocument> deviceList(int count) {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    (*doc)["status"] = "success";
+    JsonArray devices = (*doc)["devices"].to<JsonArray>();
+    for (int i = 0; i < count; i++) {
+        JsonObject device = devices.add<JsonObject>();
+        std::string id = "device-" + std::to_string(i);
+        device["id"] = id;
+        device["name"] = "Living room lamp " + std::to_string(i);
+        device["mac_address"] = "AA:BB:CC:DD:EE:" + std::to_string(10 + i % 90);
+        device["ip_address"] = "192.168.1." + std::to_string(i % 250);
+        device["hostname"] = id + ".local";
+        device["type"] = "light";
+        device["manufacturer"] = "Espressif";
+        device["model"] = "ESP32-S3";
+        device["firmware_version"] = "1.4.2";
+        device["api_version"] = "v1";
+        device["online"] = i % 3 != 0;
+        device["last_seen"] = 1700000000 + i;
+        JsonArray capabilities = device["capabilities"].to<JsonArray>();
+        capabilities.add("switch");
+        capabilities.add("dimmer");
+    }
+    (*doc)["total"] = count;
+    return doc;
+}
+
+static std::string streamed(std::shared_ptr<JsonDocument> doc, size_t window) {
+    JsonChunkSerializer serializer(doc);
+    std::string out;
+    uint8_t buffer[2048];
+    size_t produced;
+    while ((produced = serializer.read(buffer, window)) > 0) {
+        out.append((const char*)buffer, produced);
+    }
+    return out;
+}
+
+static void assertStreamsLikeSerializeJson(std::shared_ptr<JsonDocument> doc) {
+    std::string expected;
+    serializeJson(*doc, expected);
+    TEST_ASSERT_EQUAL_UINT(expected.size(), measureJson(*doc));
+
+    const size_t windows[] = {1, 2, 7, 64, 536, 1436, 2048};
+    for (size_t window : windows) {
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), streamed(doc, window).c_str());
+    }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_device_list_matches_serialize_json() {
+    assertStreamsLikeSerializeJson(deviceList(40));
+}
+
+void test_scalars_and_empty_containers() {
+    const char* inputs[] = {
+        "null", "true", "-12.5", "\"text\"", "{}", "[]",
+        "[[],{},[[]],{\"a\":{}}]",
+        "{\"a\":[1,2,[3,{\"b\":null}]],\"c\":{\"d\":false}}",
+    };
+    for (const char* input : inputs) {
+        std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+        TEST_ASSERT_FALSE(deserializeJson(*doc, input));
+        assertStreamsLikeSerializeJson(doc);
+    }
+}
+
+void test_keys_are_escaped_like_serialize_json() {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    (*doc)["quote\"back\\slash"] = 1;
+    (*doc)["tab\tnew\nline\r"] = 2;
+    (*doc)["form\fback\b"] = 3;
+    (*doc)["slash/unicode \xC3\xA9"] = 4;
+    assertStreamsLikeSerializeJson(doc);
+}
+
+void test_long_string_spans_windows() {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    std::string blob(5000, 'x');
+    blob[1234] = '"';
+    (*doc)["blob"] = blob;
+    (*doc)["after"] = "tail";
+    assertStreamsLikeSerializeJson(doc);
+}
+
+void test_finished_serializer_returns_zero() {
+    std::shared_ptr<JsonDocument> doc = std::make_shared<JsonDocument>();
+    (*doc)["a"] = 1;
+    JsonChunkSerializer serializer(doc);
+    uint8_t buffer[64];
+    TEST_ASSERT_EQUAL_UINT(7, serializer.read(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT(0, serializer.read(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT(0, serializer.read(buffer, sizeof(buffer)));
+}
+
+// Working memory on top of the document while a 60-device list goes out in
+// TCP-sized windows, next to the whole-body buffer the streaming replaces.
+// Host figures: they show the shape, on-device numbers still need hardware.
+void test_measure_streaming_memory() {
+    std::shared_ptr<JsonDocument> doc = deviceList(60);
+    size_t length = measureJson(*doc);
+    uint8_t buffer[1436];
+
+    size_t baseline = liveBytes;
+    peakBytes = liveBytes;
+    auto started = std::chrono::steady_clock::now();
+    {
+        JsonChunkSerializer serializer(doc);
+        while (serializer.read(buffer, sizeof(buffer)) > 0) {
+        }
+    }
+    double streamUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+    size_t streamPeak = peakBytes - baseline;
+
+    started = std::chrono::steady_clock::now();
+    std::string whole;
+    serializeJson(*doc, whole);
+    double wholeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+
+    char message[192];
+    snprintf(message, sizeof(message),
+             "%u-byte body: streaming peak %u bytes (%.0f us), whole-body buffer %u bytes (%.0f us)",
+             (unsigned)length, (unsigned)streamPeak, streamUs, (unsigned)length, wholeUs);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_LESS_THAN_UINT(1024, streamPeak);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_device_list_matches_serialize_json);
+    RUN_TEST(test_scalars_and_empty_containers);
+    RUN_TEST(test_keys_are_escaped_like_serialize_json);
+    RUN_TEST(test_long_string_spans_windows);
+    RUN_TEST(test_finished_serializer_returns_zero);
+    RUN_TEST(test_measure_streaming_memory);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// Host-side tests and microbenchmark for RateLimitTable: pio test -e native
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include "../../lib/MVCFramework/src/Http/RateLimitTable.cpp"
+
+// Finds count addresses, starting from a base, that share one home slot
+static void collidingAddresses(uint32_t* out, size_t count, size_t slot) {
+    uint32_t ip = 0xC0A80000;  // 192.168.0.0
+    for (size_t found = 0; found < count; ip++) {
+        if (homeSlot(ip) == slot) {
+            out[found++] = ip;
+        }
+    }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void test_spends_and_refills_tokens() {
+    RateLimitTable table(3, 3000);
+    unsigned long retryAfterMs = 0;
+    uint32_t ip = 0xC0A80001;
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(table.take(ip, 0, retryAfterMs));
+    }
+    TEST_ASSERT_FALSE(table.take(ip, 0, retryAfterMs));
+    TEST_ASSERT_UINT_WITHIN(1, 1000, retryAfterMs);
+
+    TEST_ASSERT_FALSE(table.take(ip, 500, retryAfterMs));
+    TEST_ASSERT_TRUE(table.take(ip, 1000, retryAfterMs));
+    TEST_ASSERT_EQUAL_UINT(0, retryAfterMs);
+}
+
+void test_full_probe_window_evicts_least_recently_seen() {
+    RateLimitTable table(5, 60000);
+    unsigned long retryAfterMs = 0;
+    uint32_t ips[RATE_LIMIT_PROBE_LENGTH + 1];
+    collidingAddresses(ips, RATE_LIMIT_PROBE_LENGTH + 1, 10);
+
+    // Fill every slot of the window, oldest first
+    for (size_t i = 0; i < RATE_LIMIT_PROBE_LENGTH; i++) {
+        table.take(ips[i], i, retryAfterMs);
+    }
+    for (size_t i = 0; i < RATE_LIMIT_PROBE_LENGTH; i++) {
+        TEST_ASSERT_TRUE(table.tracks(ips[i]));
+    }
+
+    // One more client for the same window replaces the oldest
+    table.take(ips[RATE_LIMIT_PROBE_LENGTH], 100, retryAfterMs);
+    TEST_ASSERT_FALSE(table.tracks(ips[0]));
+    for (size_t i = 1; i <= RATE_LIMIT_PROBE_LENGTH; i++) {
+        TEST_ASSERT_TRUE(table.tracks(ips[i]));
+    }
+}
+
+void test_recent_request_protects_from_eviction() {
+    RateLimitTable table(5, 60000);
+    unsigned long retryAfterMs = 0;
+    uint32_t ips[RATE_LIMIT_PROBE_LENGTH + 1];
+    collidingAddresses(ips, RATE_LIMIT_PROBE_LENGTH + 1, 63);  // window wraps to slot 0
+
+    for (size_t i = 0; i < RATE_LIMIT_PROBE_LENGTH; i++) {
+        table.take(ips[i], i, retryAfterMs);
+    }
+    // The first client comes back, so the second is now least recently seen
+    table.take(ips[0], 50, retryAfterMs);
+    table.take(ips[RATE_LIMIT_PROBE_LENGTH], 60, retryAfterMs);
+
+    TEST_ASSERT_TRUE(table.tracks(ips[0]));
+    TEST_ASSERT_FALSE(table.tracks(ips[1]));
+    TEST_ASSERT_TRUE(table.tracks(ips[RATE_LIMIT_PROBE_LENGTH]));
+}
+
+void test_evicted_client_starts_with_full_bucket() {
+    RateLimitTable table(2, 60000);
+    unsigned long retryAfterMs = 0;
+    uint32_t ips[RATE_LIMIT_PROBE_LENGTH + 1];
+    collidingAddresses(ips, RATE_LIMIT_PROBE_LENGTH + 1, 20);
+
+    table.take(ips[0], 0, retryAfterMs);
+    table.take(ips[0], 0, retryAfterMs);
+    TEST_ASSERT_FALSE(table.take(ips[0], 0, retryAfterMs));
+
+    for (size_t i = 1; i <= RATE_LIMIT_PROBE_LENGTH; i++) {
+        table.take(ips[i], i, retryAfterMs);
+    }
+    TEST_ASSERT_FALSE(table.tracks(ips[0]));
+    TEST_ASSERT_TRUE(table.take(ips[0], 20, retryAfterMs));
+}
+
+void test_other_windows_are_untouched() {
+    RateLimitTable table(5, 60000);
+    unsigned long retryAfterMs = 0;
+    uint32_t ips[RATE_LIMIT_PROBE_LENGTH + 1];
+    uint32_t neighbour;
+    collidingAddresses(ips, RATE_LIMIT_PROBE_LENGTH + 1, 30);
+    collidingAddresses(&neighbour, 1, 30 + RATE_LIMIT_PROBE_LENGTH);
+
+    table.take(neighbour, 0, retryAfterMs);
+    for (size_t i = 0; i <= RATE_LIMIT_PROBE_LENGTH; i++) {
+        table.take(ips[i], i + 1, retryAfterMs);
+    }
+    TEST_ASSERT_TRUE(table.tracks(neighbour));
+    TEST_ASSERT_FALSE(table.tracks(ips[0]));
+}
+
+void test_idle_clients_are_swept() {
+    RateLimitTable table(5, 1000);
+    unsigned long retryAfterMs = 0;
+    uint32_t idle = 0xC0A80001;
+    uint32_t active = 0xC0A80002;
+
+    table.take(idle, 0, retryAfterMs);
+    // Each take sweeps two slots, so half the table size covers all of it
+    for (int i = 0; i < RATE_LIMIT_TABLE_SIZE / 2; i++) {
+        table.take(active, 1000 + i, retryAfterMs);
+    }
+    TEST_ASSERT_FALSE(table.tracks(idle));
+    TEST_ASSERT_TRUE(table.tracks(active));
+}
+
+static double nsPerTake(RateLimitTable& table, uint32_t clients, int rounds) {
+    unsigned long retryAfterMs = 0;
+    volatile bool sink = false;
+    uint32_t now = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (uint32_t i = 0; i < clients; i++) {
+            sink = table.take(0x0A000000 + i, now++, retryAfterMs);
+        }
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+    (void)sink;
+    return elapsed / ((double)rounds * clients);
+}
+
+void test_benchmark_take() {
+    RateLimitTable hot(100, 60000);
+    RateLimitTable churn(100, 60000);
+    double hotNs = nsPerTake(hot, 16, 50000);
+    double churnNs = nsPerTake(churn, 1024, 800);
+
+    char message[128];
+    snprintf(message, sizeof(message), "take(): 16 clients %.1f ns, 1024 clients (evicting) %.1f ns", hotNs, churnNs);
+    TEST_MESSAGE(message);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_spends_and_refills_tokens);
+    RUN_TEST(test_full_probe_window_evicts_least_recently_seen);
+    RUN_TEST(test_recent_request_protects_from_eviction);
+    RUN_TEST(test_evicted_client_starts_with_full_bucket);
+    RUN_TEST(test_other_windows_are_untouched);
+    RUN_TEST(test_idle_clients_are_swept);
+    RUN_TEST(test_benchmark_take);
+    return UNITY_END();
+}
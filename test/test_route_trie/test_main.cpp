@@ -0,0 +1,297 @@
+// Host-side tests and benchmark for RouteTrie: pio test -e native
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+#include "../../lib/MVCFramework/src/Routing/RouteTrie.cpp"
+
+struct TestRoute {
+    HttpMethod method;
+    const char* path;
+};
+
+// The routes registered by src/Routes, in registration order
+static const TestRoute appRoutes[] = {
+    {HttpMethod::Get, "/"},
+    {HttpMethod::Get, "/dashboard"},
+    {HttpMethod::Get, "/wifi-config"},
+    {HttpMethod::Get, "/wifi-test"},
+    {HttpMethod::Get, "/iot-devices"},
+    {HttpMethod::Get, "/login"},
+    {HttpMethod::Post, "/login"},
+    {HttpMethod::Post, "/logout"},
+    {HttpMethod::Get, "/assets/{file}"},
+    {HttpMethod::Get, "/favicon.ico"},
+    {HttpMethod::Get, "/api/v1/auth/user"},
+    {HttpMethod::Post, "/api/v1/auth/password"},
+    {HttpMethod::Get, "/api/v1/admin/users"},
+    {HttpMethod::Get, "/api/wifi/status"},
+    {HttpMethod::Get, "/api/wifi/clients"},
+    {HttpMethod::Get, "/api/wifi/scan"},
+    {HttpMethod::Post, "/api/wifi/ap"},
+    {HttpMethod::Put, "/api/wifi/ap"},
+    {HttpMethod::Delete, "/api/wifi/ap"},
+    {HttpMethod::Post, "/api/wifi/clients/{id}/disconnect"},
+    {HttpMethod::Get, "/api/wifi/config"},
+    {HttpMethod::Post, "/api/wifi/config"},
+    {HttpMethod::Delete, "/api/wifi/config/{id}"},
+    {HttpMethod::Post, "/api/wifi/config/{id}/connect"},
+    {HttpMethod::Post, "/api/wifi/scan"},
+    {HttpMethod::Post, "/api/wifi/connect"},
+    {HttpMethod::Get, "/api/wifi/cleanup-networks"},
+    {HttpMethod::Get, "/api/v1/iot/devices"},
+    {HttpMethod::Get, "/api/v1/iot/devices/online"},
+    {HttpMethod::Get, "/api/v1/iot/devices/{id}"},
+    {HttpMethod::Get, "/api/v1/iot/devices/{id}/info"},
+    {HttpMethod::Post, "/api/v1/iot/devices/{id}/command"},
+    {HttpMethod::Post, "/api/v1/iot/devices/{id}/refresh"},
+    {HttpMethod::Get, "/api/v1/iot/devices/types/{type}"},
+    {HttpMethod::Get, "/api/v1/iot/devices/capabilities/{capability}"},
+    {HttpMethod::Post, "/api/v1/iot/scan"},
+    {HttpMethod::Get, "/api/v1/iot/statistics"},
+    {HttpMethod::Get, "/api/v1/iot/discovery/status"},
+    {HttpMethod::Post, "/api/v1/iot/discovery/start"},
+    {HttpMethod::Post, "/api/v1/iot/discovery/stop"},
+};
+static const size_t appRouteCount = sizeof(appRoutes) / sizeof(appRoutes[0]);
+
+// Request paths replayed by the benchmark: static hits, parameters,
+// misses and a static prefix that has to fall back to a placeholder
+static const TestRoute requests[] = {
+    {HttpMethod::Get, "/"},
+    {HttpMethod::Get, "/dashboard"},
+    {HttpMethod::Get, "/assets/app.3f9a2c1b.js"},
+    {HttpMethod::Get, "/api/wifi/status"},
+    {HttpMethod::Post, "/api/wifi/config/7/connect"},
+    {HttpMethod::Get, "/api/v1/iot/devices"},
+    {HttpMethod::Get, "/api/v1/iot/devices/online"},
+    {HttpMethod::Get, "/api/v1/iot/devices/lamp-42"},
+    {HttpMethod::Get, "/api/v1/iot/devices/lamp-42/info"},
+    {HttpMethod::Post, "/api/v1/iot/devices/lamp-42/command"},
+    {HttpMethod::Get, "/api/v1/iot/devices/types/light"},
+    {HttpMethod::Get, "/api/v1/iot/devices/online/info"},
+    {HttpMethod::Get, "/api/v1/iot/discovery/status"},
+    {HttpMethod::Get, "/api/v1/missing"},
+    {HttpMethod::Delete, "/api/wifi/config/3"},
+};
+static const size_t requestCount = sizeof(requests) / sizeof(requests[0]);
+
+static RouteTrie trie;
+
+static void buildTrie(RouteTrie& target, const TestRoute* routes, size_t count) {
+    target.clear();
+    for (size_t i = 0; i < count; i++) {
+        target.insert(routes[i].method, routes[i].path, i);
+    }
+}
+
+static int trieMatch(HttpMethod method, const char* path, RouteMatch& match) {
+    return trie.match(method, path, strlen(path), match) ? match.routeIndex : -1;
+}
+
+static String paramAt(const char* path, const RouteMatch& match, size_t index) {
+    const RouteParamSlice& slice = match.params[index];
+    return String(path).substring(slice.offset, slice.offset + slice.length);
+}
+
+// The matcher Router used before the trie: an exact pass over every route,
+// then a parametric pass that splits both paths into String segments
+static void splitSegments(const String& path, std::vector<String>& segments) {
+    String copy = path;
+    if (copy.startsWith("/")) copy = copy.substring(1);
+    if (copy.endsWith("/")) copy = copy.substring(0, copy.length() - 1);
+
+    unsigned int start = 0;
+    for (unsigned int i = 0; i <= copy.length(); i++) {
+        if (i == copy.length() || copy.charAt(i) == '/') {
+            if (i > start) {
+                segments.push_back(copy.substring(start, i));
+            }
+            start = i + 1;
+        }
+    }
+}
+
+static bool linearMatchRoute(const String& routePath, const String& path, std::map<String, String>& params) {
+    if (routePath == path) {
+        return true;
+    }
+
+    std::vector<String> routeSegments;
+    std::vector<String> pathSegments;
+    splitSegments(routePath, routeSegments);
+    splitSegments(path, pathSegments);
+    if (routeSegments.size() != pathSegments.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < routeSegments.size(); i++) {
+        const String& routeSegment = routeSegments[i];
+        if (routeSegment.startsWith("{") && routeSegment.endsWith("}")) {
+            params[routeSegment.substring(1, routeSegment.length() - 1)] = pathSegments[i];
+        } else if (routeSegment != pathSegments[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int linearMatch(HttpMethod method, const char* url, std::map<String, String>& params) {
+    String methodName = httpMethodName(method);
+    String path = url;
+
+    for (size_t i = 0; i < appRouteCount; i++) {
+        if (methodName == httpMethodName(appRoutes[i].method) && path == appRoutes[i].path) {
+            return i;
+        }
+    }
+    for (size_t i = 0; i < appRouteCount; i++) {
+        String routePath = appRoutes[i].path;
+        if (methodName == httpMethodName(appRoutes[i].method) && routePath.indexOf('{') >= 0 &&
+            linearMatchRoute(routePath, path, params)) {
+            // The old router matched twice: once to pick, once for parameters
+            params.clear();
+            linearMatchRoute(routePath, path, params);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void setUp() {
+    buildTrie(trie, appRoutes, appRouteCount);
+}
+
+void tearDown() {
+}
+
+void test_static_routes_match_by_method() {
+    RouteMatch match;
+    TEST_ASSERT_EQUAL_INT(5, trieMatch(HttpMethod::Get, "/login", match));
+    TEST_ASSERT_EQUAL_INT(6, trieMatch(HttpMethod::Post, "/login", match));
+    TEST_ASSERT_EQUAL_INT(0, trieMatch(HttpMethod::Get, "/", match));
+    TEST_ASSERT_EQUAL_INT(-1, trieMatch(HttpMethod::Put, "/login", match));
+    TEST_ASSERT_EQUAL_INT(-1, trieMatch(HttpMethod::Get, "/logout", match));
+}
+
+void test_slashes_are_not_significant() {
+    RouteMatch match;
+    TEST_ASSERT_EQUAL_INT(1, trieMatch(HttpMethod::Get, "/dashboard/", match));
+    TEST_ASSERT_EQUAL_INT(13, trieMatch(HttpMethod::Get, "/api//wifi/status", match));
+}
+
+void test_parameters_are_sliced_from_the_path() {
+    RouteMatch match;
+    const char* path = "/api/v1/iot/devices/lamp-42/command";
+    TEST_ASSERT_EQUAL_INT(31, trieMatch(HttpMethod::Post, path, match));
+    TEST_ASSERT_EQUAL_UINT8(1, match.paramCount);
+    TEST_ASSERT_EQUAL_STRING("lamp-42", paramAt(path, match, 0).c_str());
+
+    path = "/api/wifi/config/3";
+    TEST_ASSERT_EQUAL_INT(22, trieMatch(HttpMethod::Delete, path, match));
+    TEST_ASSERT_EQUAL_STRING("3", paramAt(path, match, 0).c_str());
+}
+
+void test_static_segment_wins_over_placeholder() {
+    RouteMatch match;
+    TEST_ASSERT_EQUAL_INT(28, trieMatch(HttpMethod::Get, "/api/v1/iot/devices/online", match));
+    TEST_ASSERT_EQUAL_UINT8(0, match.paramCount);
+}
+
+void test_backtracks_from_static_to_placeholder() {
+    // "online" is a static child of /devices, but /devices/online/info only
+    // exists through the {id} branch
+    RouteMatch match;
+    const char* path = "/api/v1/iot/devices/online/info";
+    TEST_ASSERT_EQUAL_INT(30, trieMatch(HttpMethod::Get, path, match));
+    TEST_ASSERT_EQUAL_UINT8(1, match.paramCount);
+    TEST_ASSERT_EQUAL_STRING("online", paramAt(path, match, 0).c_str());
+
+    // Same for "types" when the path is one segment short of /types/{type}
+    path = "/api/v1/iot/devices/types";
+    TEST_ASSERT_EQUAL_INT(29, trieMatch(HttpMethod::Get, path, match));
+    TEST_ASSERT_EQUAL_STRING("types", paramAt(path, match, 0).c_str());
+}
+
+void test_failed_branch_does_not_leak_parameters() {
+    RouteTrie local;
+    local.insert(HttpMethod::Get, "/{a}/x", 0);
+    local.insert(HttpMethod::Get, "/{a}/{b}/y", 1);
+
+    RouteMatch match;
+    const char* path = "/one/two/y";
+    TEST_ASSERT_TRUE(local.match(HttpMethod::Get, path, strlen(path), match));
+    TEST_ASSERT_EQUAL_INT(1, match.routeIndex);
+    TEST_ASSERT_EQUAL_UINT8(2, match.paramCount);
+    TEST_ASSERT_EQUAL_STRING("one", paramAt(path, match, 0).c_str());
+    TEST_ASSERT_EQUAL_STRING("two", paramAt(path, match, 1).c_str());
+}
+
+void test_insert_rejects_duplicates_and_extra_parameters() {
+    RouteTrie local;
+    TEST_ASSERT_TRUE(local.insert(HttpMethod::Get, "/a/{id}", 0));
+    TEST_ASSERT_FALSE(local.insert(HttpMethod::Get, "/a/{other}", 1));
+    TEST_ASSERT_TRUE(local.insert(HttpMethod::Post, "/a/{id}", 2));
+    TEST_ASSERT_FALSE(local.insert(HttpMethod::Get, "/{a}/{b}/{c}/{d}/{e}", 3));
+}
+
+void test_matches_linear_scan_on_app_routes() {
+    for (size_t i = 0; i < requestCount; i++) {
+        RouteMatch match;
+        std::map<String, String> params;
+        int expected = linearMatch(requests[i].method, requests[i].path, params);
+        int actual = trieMatch(requests[i].method, requests[i].path, match);
+        if (expected != actual) {
+            char message[128];
+            snprintf(message, sizeof(message), "%s %s: linear %d, trie %d",
+                     httpMethodName(requests[i].method), requests[i].path, expected, actual);
+            TEST_FAIL_MESSAGE(message);
+        }
+        TEST_ASSERT_EQUAL_UINT(params.size(), match.paramCount);
+    }
+}
+
+void test_benchmark_against_linear_scan() {
+    const int rounds = 20000;
+    volatile int sink = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < requestCount; i++) {
+            std::map<String, String> params;
+            sink += linearMatch(requests[i].method, requests[i].path, params);
+        }
+    }
+    double linearNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+
+    started = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < requestCount; i++) {
+            RouteMatch match;
+            sink += trieMatch(requests[i].method, requests[i].path, match);
+        }
+    }
+    double trieNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+
+    double lookups = (double)rounds * requestCount;
+    char message[160];
+    snprintf(message, sizeof(message), "%u routes, %u trie nodes: linear %.0f ns/match, trie %.0f ns/match (%.1fx)",
+             (unsigned)appRouteCount, (unsigned)trie.size(), linearNs / lookups, trieNs / lookups, linearNs / trieNs);
+    TEST_MESSAGE(message);
+    (void)sink;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_static_routes_match_by_method);
+    RUN_TEST(test_slashes_are_not_significant);
+    RUN_TEST(test_parameters_are_sliced_from_the_path);
+    RUN_TEST(test_static_segment_wins_over_placeholder);
+    RUN_TEST(test_backtracks_from_static_to_placeholder);
+    RUN_TEST(test_failed_branch_does_not_leak_parameters);
+    RUN_TEST(test_insert_rejects_duplicates_and_extra_parameters);
+    RUN_TEST(test_matches_linear_scan_on_app_routes);
+    RUN_TEST(test_benchmark_against_linear_scan);
+    return UNITY_END();
+}